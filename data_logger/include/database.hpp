@@ -1,9 +1,22 @@
 #pragma once
+#include "message_headers.hpp"
 #include <string>
+#include <cstddef>
+#include <memory>
 #include <yaml-cpp/yaml.h>
 #include <iostream>
 #include <sstream>
 
+// One feature_extractor result, pointing into the received message parts
+struct FrameRecord {
+    FeatureHeader header;
+    const uint8_t* image = nullptr;     // header.image.pixel_count bytes, see header.image.codec
+    size_t image_size = 0;
+    std::shared_ptr<const void> image_owner;    // keeps image alive after logData returns, if set
+    const float* features = nullptr;    // header.feature_count values
+    size_t feature_count = 0;
+};
+
 // Abstract base class for databases
 class Database {
 public:
@@ -14,7 +27,7 @@ public:
     Database(const std::string& name);
 
     // Data logging API
-    virtual bool logData(const std::string& payload) = 0;
+    virtual bool logData(const FrameRecord& record) = 0;
 
     // Utility method for diagnostics or testing
     virtual void printStatus() const;
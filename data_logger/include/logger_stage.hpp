@@ -0,0 +1,12 @@
+// Entry point of the data_logger stage, shared by its own binary and the single-process pipeline
+#pragma once
+#include "pipeline_config.hpp"
+#include <string>
+#include <zmq.hpp>
+
+inline constexpr const char* kDataLoggerConfigPath = "configs/data_logger/PostgreSQL/config.yml";
+
+// Receives feature messages on the features endpoint and logs them to the database until
+// ShutdownHandler reports shutdown. Returns the process exit code.
+int runDataLogger(zmq::context_t& ctx, const TransportConfig& transport,
+                  const std::string& db_config_path = kDataLoggerConfigPath);
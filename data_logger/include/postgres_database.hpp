@@ -1,16 +1,29 @@
 #pragma once
 #include "database.hpp"
+#include "retention_manager.hpp"
+#include "postgres_writer.hpp"
+#include "ring_queue.hpp"
+#include "feature_index.hpp"
 #include <vector>
 #include <pqxx/pqxx>
-#include <chrono>
+#include <unordered_set>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 
 class PostgresDatabase : public Database {
 public:
     explicit PostgresDatabase(const std::string& config_path);
     ~PostgresDatabase() override;
 
-    // Main public operation
-    bool logData(const std::string& payload) override;
+    // Main public operation. Queues the frame for the writer pool and returns; blocks only
+    // while every writer is busy and the queue is full.
+    bool logData(const FrameRecord& record) override;
+
+    // Similarity index over every logged image, nullptr when similarity_index is disabled.
+    // Loaded from the database at startup and extended by the writers after each commit.
+    FeatureIndex* featureIndex() { return index.get(); }
+    const std::string& featureQueryEndpoint() const { return index_endpoint; }
 
 protected:
     // Internal virtual overrides
@@ -20,20 +33,47 @@ protected:
 
 private:
     std::string connectionInfo;
-    std::unique_ptr<pqxx::connection> connection;
+    std::unique_ptr<pqxx::connection> connection;   // schema, warmup and retention setup
     bool split_payload = false;
 
-    // --- size check parameters ---
-    long long max_db_size_bytes = 1LL * 1024 * 1024 * 1024;
-    int t_size_check_period = 300;       // seconds
-    size_t insert_count_size_check = 1000;  // number of inserts
-    size_t insert_counter = 0;
-    bool db_too_large_cached = false;
-    std::chrono::steady_clock::time_point last_size_check_time;
+    // --- writer pool ---
+    // each writer thread owns one pipelined connection and takes up to pipeline_depth frames
+    // from the queue per round-trip
+    size_t writer_connections = 4;
+    size_t pipeline_depth = 64;
+    std::unique_ptr<MpmcQueue<PendingFrame>> pending;
+    std::vector<std::thread> writers;
+
+    // --- partitioning and size limit ---
+    // rough per-row cost on top of the payload: tuple header, index entries, alignment
+    static constexpr size_t kRowOverheadBytes = 64;
+    RetentionConfig retention_config;
+    std::vector<std::string> partitioned_tables;
+    std::unique_ptr<RetentionManager> retention;
+
+    // --- content-addressed images ---
+    // hashes known to be in the images table, so repeats skip the insert entirely.
+    // Shared by logData and every writer thread.
+    size_t known_hash_capacity = 100000;
+    std::mutex known_hash_mtx;
+    std::unordered_set<int64_t> known_image_hashes;
+    uint64_t seen_prune_epoch = 0;
+
+    // --- similarity search ---
+    std::unique_ptr<FeatureIndex> index;
+    std::string index_endpoint = "ipc:///tmp/feature_query.sock";
+    size_t index_lists = 256;
+    size_t index_probes = 8;
 
     // --- internal helpers ---
-    bool logSplitPayload(pqxx::work& txn, const std::string& payload);
-    bool logUnsplitPayload(pqxx::work& txn, const std::string& payload);
-    bool shouldRecheckSize();
-    bool isDatabaseTooLarge();
+    void loadKnownImageHashes();
+    void loadFeatureIndex();
+    void indexBatch(const std::vector<PendingFrame>& batch, const std::vector<WriteOutcome>& outcomes);
+    bool isKnownImageHash(int64_t hash);
+    void rememberImageHashes(const std::vector<PendingFrame>& batch,
+                             const std::vector<WriteOutcome>& outcomes);
+    bool startWriters();
+    void stopWriters();
+    void writerLoop(size_t index, std::unique_ptr<PostgresWriter> writer);
+    void startRetention();
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include "message_headers.hpp"
+#include <libpq-fe.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A frame queued for a writer thread. The image stays in the buffer it was received in,
+// kept alive by image_owner until the writer is done with it; the features are copied.
+struct PendingFrame {
+    FeatureHeader header;
+    int64_t image_hash = 0;
+    bool image_known = false;       // already in the images table, not sent again
+    const uint8_t* image = nullptr;
+    size_t image_size = 0;
+    std::shared_ptr<const void> image_owner;
+    std::vector<float> features;
+};
+
+// What happened to one frame of a batch
+struct WriteOutcome {
+    bool ok = false;
+    bool image_inserted = false;    // a new images row, not an ON CONFLICT no-op
+    bool image_missing = false;     // the images row it refers to is gone (foreign key violation)
+};
+
+// One pooled connection in libpq pipeline mode. A batch is sent without waiting for any
+// reply, then all replies are read back, so a round-trip is paid per batch instead of per
+// statement. Parameters are bound in binary where they are bytes (BYTEA).
+class PostgresWriter {
+public:
+    PostgresWriter(std::string connection_info, std::string payload_table, bool split_payload);
+    ~PostgresWriter();
+
+    PostgresWriter(const PostgresWriter&) = delete;
+    PostgresWriter& operator=(const PostgresWriter&) = delete;
+
+    // Connects (again), prepares the insert statements and enters pipeline mode
+    bool connect();
+    bool connected() const;
+
+    // Writes the whole batch in one transaction. If it fails, every frame is retried in its
+    // own transaction so one bad frame cannot take the rest of the batch down with it. A
+    // frame queued as image_known whose image retention has pruned since is sent again with
+    // its image. outcomes is resized to batch.size().
+    void write(const std::vector<PendingFrame>& batch, std::vector<WriteOutcome>& outcomes);
+
+private:
+    std::string connectionInfo;
+    std::string payloadTable;
+    bool split_payload;
+    PGconn* conn = nullptr;
+
+    // statements counts what was queued for the frame, so replies can be matched back to it
+    // even when sending stopped halfway
+    bool sendFrame(const PendingFrame& frame, bool& sent_image, size_t& statements);
+    bool sendSplit(const PendingFrame& frame, bool& sent_image, size_t& statements);
+    bool sendUnsplit(const PendingFrame& frame, size_t& statements);
+
+    // Sends frames [first, last) as one pipeline segment and reads every reply back.
+    // Returns false if anything in the segment failed (and so was rolled back).
+    bool writeSegment(const std::vector<PendingFrame>& batch, size_t first, size_t last,
+                      std::vector<WriteOutcome>& outcomes);
+
+    void reportError(const char* what) const;
+};
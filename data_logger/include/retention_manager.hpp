@@ -0,0 +1,106 @@
+#pragma once
+#include <pqxx/pqxx>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What happens to a partition that falls out of the size budget
+enum class RetentionAction {
+    Drop,       // DROP TABLE, space is returned immediately
+    Detach,     // DETACH PARTITION, kept as a standalone table for archiving
+};
+
+struct RetentionConfig {
+    long long max_bytes = 1LL * 1024 * 1024 * 1024;
+    int partition_interval_s = 3600;
+    int check_period_s = 30;
+    RetentionAction action = RetentionAction::Drop;
+};
+
+// Keeps time-range partitions ahead of the clock and enforces the size limit by dropping
+// (or detaching) whole partitions, oldest first, from a background thread with its own
+// connection. The insert path only reports how many bytes it wrote; the database is
+// measured when a partition closes, never while logging.
+class RetentionManager {
+public:
+    RetentionManager(const std::string& connection_info,
+                     std::vector<std::string> partitioned_tables,
+                     std::string images_table,
+                     std::string features_table,
+                     RetentionConfig config);
+    ~RetentionManager();
+
+    // Measures existing partitions and creates the current and next ones before returning,
+    // so the first inserts never land in the default partition. Then starts the thread.
+    bool start();
+    void stop();
+
+    // Called from the insert path: bytes written to partitioned tables / the images table
+    void accountRows(size_t bytes) { unflushed_row_bytes.fetch_add(bytes, std::memory_order_relaxed); }
+    void accountImage(size_t bytes) { unflushed_image_bytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // Bumped whenever unreferenced images were deleted, so callers can forget cached hashes
+    uint64_t imagesPrunedEpoch() const { return images_pruned_epoch.load(std::memory_order_acquire); }
+
+    // Set before start(). Called on the retention thread once an interval's partitions are
+    // dropped or detached, with the interval's end: no row logged before it is left.
+    void onIntervalRemoved(std::function<void(long long end_s)> callback) {
+        interval_removed = std::move(callback);
+    }
+
+private:
+    struct Bucket {
+        long long bytes = 0;
+        bool measured = false;  // bytes came from pg_total_relation_size, not estimates
+    };
+
+    std::string connectionInfo;
+    std::vector<std::string> tables;
+    std::string imagesTable;    // content-addressed, pruned once no feature row refers to it
+    std::string featuresTable;
+    RetentionConfig cfg;
+
+    std::unique_ptr<pqxx::connection> connection;
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::atomic<size_t> unflushed_row_bytes{0};
+    std::atomic<size_t> unflushed_image_bytes{0};
+    std::atomic<uint64_t> images_pruned_epoch{0};
+    std::function<void(long long)> interval_removed;
+
+    // interval start (unix seconds) -> bytes across every partitioned table for that interval
+    std::map<long long, Bucket> buckets;
+    // detached intervals, still on disk and still referencing images until an operator
+    // archives and drops the tables
+    std::map<long long, Bucket> detached;
+    long long images_bytes = 0;
+    long long base_bytes = 0;   // default partitions, never dropped
+    bool prune_pending = false; // the last prune lost a race with a writer
+
+    void run();
+    void tick();
+    void measureExisting();
+    void ensurePartitions(long long now_s);
+    void measureClosedBuckets(long long current_start);
+    void enforceLimit(long long current_start);
+    bool reapDetached();
+    long long pruneOrphanImages();
+
+    long long intervalStart(long long unix_s) const;
+    std::string partitionName(const std::string& table, long long start_s) const;
+    long long relationSize(pqxx::work& txn, const std::string& relation);
+    bool parsePartitionStart(const std::string& table, const std::string& name, long long& start) const;
+    long long totalBytes() const;
+    long long detachedBytes() const;
+};
@@ -0,0 +1,190 @@
+#include "logger_stage.hpp"
+#include "shared.hpp"
+#include "shutdown_handler.hpp"
+#include "postgres_database.hpp"
+#include "transport.hpp"
+#include "runtime_profile.hpp"
+#include "trace.hpp"
+#include "feature_query.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Answers similarity queries (feature_query.hpp) from the database's index until shutdown
+static void queryLoop(zmq::context_t& ctx, const std::string& endpoint, FeatureIndex& index) {
+    trace_thread_name("data_logger/query");
+
+    zmq::socket_t socket(ctx, zmq::socket_type::rep);
+    socket.set(zmq::sockopt::rcvtimeo, 100);
+    socket.set(zmq::sockopt::linger, 0);
+    try {
+        socket.bind(endpoint);
+    } catch (const zmq::error_t& e) {
+        std::cerr << "[Index] Cannot serve queries on " << endpoint << ": " << e.what() << std::endl;
+        return;
+    }
+    std::cout << "[Index] Serving similarity queries on " << endpoint << std::endl;
+
+    constexpr uint32_t kMaxMatches = 1000;
+
+    while (ShutdownHandler::running()) {
+        try {
+            std::vector<zmq::message_t> parts(1);
+            if (!socket.recv(parts[0], zmq::recv_flags::none)) continue;   // timed out
+            while (parts.back().more()) {
+                parts.emplace_back();
+                (void)socket.recv(parts.back(), zmq::recv_flags::none);
+            }
+
+            const auto started = std::chrono::steady_clock::now();
+            FeatureQueryReply reply{};
+            std::vector<IndexMatch> found;
+
+            FeatureQuery query{};
+            std::vector<float> vec;
+            if (parts.size() != 2 || parts[0].size() != sizeof(FeatureQuery)) {
+                reply.status = static_cast<uint32_t>(FeatureQueryStatus::Malformed);
+            } else {
+                std::memcpy(&query, parts[0].data(), sizeof(query));
+                if (parts[1].size() != size_t(query.dims) * sizeof(float)) {
+                    reply.status = static_cast<uint32_t>(FeatureQueryStatus::Malformed);
+                } else if (query.dims) {
+                    // message parts carry no alignment guarantee
+                    vec.resize(query.dims);
+                    std::memcpy(vec.data(), parts[1].data(), parts[1].size());
+                } else if (!index.vectorOf(query.image_hash, vec)) {
+                    reply.status = static_cast<uint32_t>(FeatureQueryStatus::UnknownImage);
+                }
+            }
+
+            if (reply.status == static_cast<uint32_t>(FeatureQueryStatus::Ok))
+                found = index.search(vec.data(), vec.size(), std::min(query.k, kMaxMatches), query.probes);
+
+            std::vector<FeatureQueryMatch> matches;
+            matches.reserve(found.size());
+            for (const IndexMatch& m : found)
+                matches.push_back({m.image_hash, m.last_frame, m.frames, m.distance});
+
+            reply.count = static_cast<uint32_t>(matches.size());
+            reply.indexed = index.size();
+            reply.search_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count();
+
+            socket.send(zmq::buffer(&reply, sizeof(reply)), zmq::send_flags::sndmore);
+            socket.send(zmq::buffer(matches), zmq::send_flags::none);
+        } catch (const zmq::error_t& e) {
+            if (e.num() != EINTR) std::cerr << "[Index] ZMQ error: " << e.what() << std::endl;
+        }
+    }
+}
+
+int runDataLogger(zmq::context_t& ctx, const TransportConfig& transport,
+                  const std::string& db_config_path) {
+    print_banner("Data Logger Started");
+
+    // before the database starts its writer and retention threads, so they inherit it
+    const RuntimeProfile profile = loadRuntimeProfile("data_logger");
+    applyRuntimeProfile("data_logger", profile);
+    pinIoThreads(ctx, profile.cpus);
+
+    TraceSession tracing("data_logger");
+    trace_thread_name("data_logger/receiver");
+
+    PostgresDatabase db(db_config_path);
+    db.printStatus();
+
+    if(!db.isConnected){
+        std::cout << "unable to connect to database, terminating\n"; 
+        return 1;
+    }
+
+    // pubsub connects to the single feature extractor, pushpull binds so every extractor
+    // instance can connect and fan its results in
+    zmq::socket_t subscriber = makeFeatureReceiver(ctx, transport);
+
+    std::cout << "Listening for messages on " << transport.features_endpoint
+              << " (" << transport_mode_name(transport.mode) << ") ..." << std::endl;
+
+    // wake up periodically so shutdown is noticed even when no frames arrive
+    subscriber.set(zmq::sockopt::rcvtimeo, 100);
+
+    // nearest-image queries over everything logged, see utility/feature_query
+    std::thread query_server;
+    if (FeatureIndex* index = db.featureIndex())
+        query_server = std::thread(queryLoop, std::ref(ctx), db.featureQueryEndpoint(), std::ref(*index));
+
+    // only the receiver is latency-critical; writers, retention and queries stay time-sliced
+    applyRealtimePriority("data_logger/receiver", profile);
+
+    try {
+        while (ShutdownHandler::running()) {
+            // ---- Frame 0: header ----
+            zmq::message_t header_msg;
+
+            // zmq::recv_result_t === std::optional<size_t>
+            zmq::recv_result_t received = recvFirstPart(subscriber, header_msg, profile.busy_poll);
+            if (!received) continue; // timed out
+
+            if (!header_msg.more() || header_msg.size() != sizeof(FeatureHeader)) {
+                std::cerr << "[WARN] Dropping malformed message (" << header_msg.size() << " bytes)\n";
+                while (subscriber.get(zmq::sockopt::rcvmore)) {
+                    zmq::message_t rest;
+                    (void)subscriber.recv(rest, zmq::recv_flags::none);
+                }
+                continue;
+            }
+
+            FrameRecord record;
+            std::memcpy(&record.header, header_msg.data(), sizeof(FeatureHeader));
+
+            // ---- Frame 1: image bytes, Frame 2: float32 features ----
+            // the image message is handed to the writers as is and freed once committed
+            auto image_msg = std::make_shared<zmq::message_t>();
+            zmq::message_t features_msg;
+            {
+                TraceSpan span("receive", record.header.image.frame_number);
+                if (!subscriber.recv(*image_msg, zmq::recv_flags::none) || !image_msg->more()
+                    || !subscriber.recv(features_msg, zmq::recv_flags::none)) {
+                    std::cerr << "[WARN] Dropping incomplete message\n";
+                    continue;
+                }
+            }
+
+            // message parts carry no alignment guarantee, copy the (small) float vector out
+            std::vector<float> features(features_msg.size() / sizeof(float));
+            std::memcpy(features.data(), features_msg.data(), features.size() * sizeof(float));
+
+            record.image = static_cast<const uint8_t*>(image_msg->data());
+            record.image_size = image_msg->size();
+            record.image_owner = image_msg;
+            record.features = features.data();
+            record.feature_count = features.size();
+
+            if (record.feature_count != record.header.feature_count) {
+                std::cerr << "[WARN] Frame #" << record.header.image.frame_number
+                          << " announces " << record.header.feature_count << " features, got "
+                          << record.feature_count << "\n";
+                continue;
+            }
+
+            // queues the frame for the writers; blocks while every writer connection is behind
+            TraceSpan span("enqueue", record.header.image.frame_number);
+            db.logData(record);
+        }
+    }
+    catch (const zmq::error_t& e) {
+        if (!ShutdownHandler::running() && e.num() == EINTR) {
+            // Interrupted by a shutdown signal — normal exit
+        } else {
+            std::cerr << "ZMQ error: " << e.what() << std::endl;
+        }
+    }
+
+    if (query_server.joinable()) query_server.join();
+
+    print_banner("Data Logger Terminated");
+    return 0;
+}
@@ -1,4 +1,11 @@
 #include "postgres_database.hpp"
+#include "content_hash.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
 
 PostgresDatabase::PostgresDatabase(const std::string& config_path)
     : Database(config_path) {
@@ -11,25 +18,54 @@ PostgresDatabase::PostgresDatabase(const std::string& config_path)
         auto dh = config["data_handling"];
         if (dh["split_payload"]) split_payload = dh["split_payload"].as<bool>();
         if (dh["max_db_size_mb"])
-            max_db_size_bytes = static_cast<long long>(dh["max_db_size_mb"].as<int>()) * 1024 * 1024;
-        if (dh["t_size_check_period"])
-            t_size_check_period = dh["t_size_check_period"].as<int>();
-        if (dh["insert_count_size_check"])
-            insert_count_size_check = dh["insert_count_size_check"].as<int>();
+            retention_config.max_bytes = static_cast<long long>(dh["max_db_size_mb"].as<int>()) * 1024 * 1024;
+        if (dh["partition_interval_s"])
+            retention_config.partition_interval_s = dh["partition_interval_s"].as<int>();
+        if (dh["retention_check_period_s"])
+            retention_config.check_period_s = dh["retention_check_period_s"].as<int>();
+        if (dh["retention_action"]) {
+            const std::string action = dh["retention_action"].as<std::string>();
+            if (action == "drop")        retention_config.action = RetentionAction::Drop;
+            else if (action == "detach") retention_config.action = RetentionAction::Detach;
+            else std::cerr << "Unknown retention_action '" << action << "', dropping partitions\n";
+        }
+        if (dh["known_hash_cache_entries"])
+            known_hash_capacity = dh["known_hash_cache_entries"].as<size_t>();
+        if (dh["writer_connections"])
+            writer_connections = std::max<size_t>(1, dh["writer_connections"].as<size_t>());
+        if (dh["pipeline_depth"])
+            pipeline_depth = std::max<size_t>(1, dh["pipeline_depth"].as<size_t>());
     }
 
-    std::cout << "Split payload: " << (split_payload ? "ENABLED" : "DISABLED")
-              << " | Max DB size: " << (max_db_size_bytes / (1024 * 1024))
-              << " MB | Check period: " << t_size_check_period
-              << " s | Check every " << insert_count_size_check
-              << " inserts\n";
-
-    if (connect()) setupSchema();
+    // similarity_index section, enabled unless it says otherwise
+    const auto& si = config["similarity_index"];
+    if (!si || !si["enabled"] || si["enabled"].as<bool>()) {
+        if (si && si["endpoint"]) index_endpoint = si["endpoint"].as<std::string>();
+        if (si && si["lists"])    index_lists = std::max<size_t>(1, si["lists"].as<size_t>());
+        if (si && si["probes"])   index_probes = std::max<size_t>(1, si["probes"].as<size_t>());
+        index = std::make_unique<FeatureIndex>(index_lists, index_probes);
+    }
 
-    last_size_check_time = std::chrono::steady_clock::now();
+    std::cout << "Split payload: " << (split_payload ? "ENABLED" : "DISABLED")
+              << " | Max DB size: " << (retention_config.max_bytes / (1024 * 1024))
+              << " MB | Partition interval: " << retention_config.partition_interval_s
+              << " s | Retention: " << (retention_config.action == RetentionAction::Drop ? "drop" : "detach")
+              << " every " << retention_config.check_period_s << " s"
+              << " | Writers: " << writer_connections << " x " << pipeline_depth << " in flight\n";
+
+    if (connect() && setupSchema()) {
+        startRetention();
+        if (split_payload) loadKnownImageHashes();
+        if (index) loadFeatureIndex();
+        if (!startWriters()) isConnected = false;
+    }
 }
 
 PostgresDatabase::~PostgresDatabase() {
+    // writers drain what is already queued before the retention thread goes away
+    stopWriters();
+    if (retention) retention->stop();
+
     if (connection && connection->is_open()) {
         std::cout << "Closing PostgreSQL connection to "
                   << dbName << std::endl;
@@ -72,9 +108,10 @@ bool PostgresDatabase::setupSchema() {
         for (auto it = tables.begin(); it != tables.end(); ++it) {
             if (!it->second["enabled"].as<bool>()) continue;
 
+            const std::string name = it->second["name"].as<std::string>();
+
             std::ostringstream query;
-            query << "CREATE TABLE IF NOT EXISTS "
-                  << it->second["name"].as<std::string>() << " (";
+            query << "CREATE TABLE IF NOT EXISTS " << name << " (";
 
             const auto& cols = it->second["columns"];
             bool first = true;
@@ -84,9 +121,34 @@ bool PostgresDatabase::setupSchema() {
                 query << c->first.as<std::string>() << " "
                       << c->second.as<std::string>();
             }
-            query << ");";
+
+            // partitioned tables need the partition key in their primary key
+            if (it->second["primary_key"])
+                query << ", PRIMARY KEY (" << it->second["primary_key"].as<std::string>() << ")";
+            query << ")";
+
+            if (it->second["partition_by"]) {
+                query << " PARTITION BY RANGE (" << it->second["partition_by"].as<std::string>() << ")";
+                partitioned_tables.push_back(name);
+            }
+            query << ";";
 
             txn.exec(query.str());
+
+            // catches rows outside every range partition instead of failing the insert
+            if (it->second["partition_by"]) {
+                txn.exec("CREATE TABLE IF NOT EXISTS " + name + "_default PARTITION OF "
+                         + name + " DEFAULT;");
+            }
+
+            // created on the parent, so every partition gets (and keeps, once detached) its own
+            if (it->second["indexes"]) {
+                for (const auto& column : it->second["indexes"]) {
+                    const std::string col = column.as<std::string>();
+                    txn.exec("CREATE INDEX IF NOT EXISTS " + name + "_" + col + "_idx ON "
+                             + name + " (" + col + ");");
+                }
+            }
         }
 
         txn.commit();
@@ -102,126 +164,340 @@ bool PostgresDatabase::setupSchema() {
 //  Database size management
 // -----------------------------------------------------------
 
-bool PostgresDatabase::shouldRecheckSize() {
-    using namespace std::chrono;
-    auto now = steady_clock::now();
-    auto elapsed = duration_cast<seconds>(now - last_size_check_time).count();
+// Partition creation and the size limit are handled off the insert path; logging never
+// stops, the oldest partitions make room instead
+void PostgresDatabase::startRetention() {
+    const auto& tables = config["tables"];
+    auto tableName = [&](const char* key) {
+        return tables[key] && tables[key]["enabled"].as<bool>()
+            ? tables[key]["name"].as<std::string>() : std::string();
+    };
+
+    retention = std::make_unique<RetentionManager>(
+        connectionInfo, partitioned_tables, tableName("images"), tableName("features"),
+        retention_config);
+
+    // every row of an image that was last logged before the interval's end went with it
+    if (index) {
+        retention->onIntervalRemoved([this](long long end_s) {
+            const size_t removed = index->removeLoggedBefore(end_s);
+            if (removed > 0)
+                std::cout << "[Index] Removed " << removed << " images no longer logged" << std::endl;
+        });
+    }
 
-    if (elapsed >= t_size_check_period || insert_counter >= insert_count_size_check) {
-        insert_counter = 0;
-        last_size_check_time = now;
-        return true;
+    if (!retention->start()) {
+        std::cerr << "[Postgres] Retention disabled, the size limit will not be enforced" << std::endl;
+        retention.reset();
     }
-    return false;
 }
 
-bool PostgresDatabase::isDatabaseTooLarge() {
+// -----------------------------------------------------------
+//  Content-addressed images
+// -----------------------------------------------------------
+
+// Warms the local hash cache from the images table in batches, so images logged by a
+// previous run are not re-sent either. Keyset pagination keeps every batch an index scan.
+void PostgresDatabase::loadKnownImageHashes() {
+    constexpr size_t kBatch = 10000;
+
     try {
         pqxx::work txn(*connection);
-        pqxx::result r = txn.exec("SELECT pg_database_size(current_database());");
-        long long size = r[0][0].as<long long>();
-        db_too_large_cached = size > max_db_size_bytes;
+        bool first = true;
+        long long last = 0;
 
-        std::cout << "[Postgres] DB size = " << (size / (1024 * 1024)) << " MB → "
-                  << (db_too_large_cached ? "TOO LARGE" : "OK") << std::endl;
+        while (known_image_hashes.size() < known_hash_capacity) {
+            const size_t want = std::min(kBatch, known_hash_capacity - known_image_hashes.size());
 
-        return db_too_large_cached;
+            std::ostringstream query;
+            query << "SELECT content_hash FROM images";
+            if (!first) query << " WHERE content_hash > " << last;
+            query << " ORDER BY content_hash LIMIT " << want << ";";
+
+            pqxx::result r = txn.exec(query.str());
+            for (const auto& row : r) {
+                last = row[0].as<long long>();
+                known_image_hashes.insert(last);
+            }
+            first = false;
+
+            if (r.size() < want) break;
+        }
+
+        txn.commit();
+        std::cout << "[Postgres] Loaded " << known_image_hashes.size()
+                  << " known image hashes" << std::endl;
     } catch (const std::exception& e) {
-        std::cerr << "[Postgres] Failed to check size: " << e.what() << std::endl;
-        return db_too_large_cached; // retain previous status
+        std::cerr << "[Postgres] Failed to load known image hashes: " << e.what() << std::endl;
+    }
+}
+
+bool PostgresDatabase::isKnownImageHash(int64_t hash) {
+    std::lock_guard<std::mutex> lock(known_hash_mtx);
+
+    // retention deleted images nothing referenced any more; cached hashes may be stale
+    if (retention && retention->imagesPrunedEpoch() != seen_prune_epoch) {
+        seen_prune_epoch = retention->imagesPrunedEpoch();
+        known_image_hashes.clear();
+    }
+    return known_image_hashes.count(hash) != 0;
+}
+
+// Only called for committed frames, so a rolled back image insert is retried next time
+void PostgresDatabase::rememberImageHashes(const std::vector<PendingFrame>& batch,
+                                           const std::vector<WriteOutcome>& outcomes) {
+    if (known_hash_capacity == 0) return;
+    std::lock_guard<std::mutex> lock(known_hash_mtx);
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        // a known image only counts if the writer had to store it again after a prune
+        if (!outcomes[i].ok || (batch[i].image_known && !outcomes[i].image_inserted)) continue;
+
+        // forgetting everything is safe: a forgotten hash only costs one ON CONFLICT no-op insert
+        if (known_image_hashes.size() >= known_hash_capacity)
+            known_image_hashes.clear();
+
+        known_image_hashes.insert(batch[i].image_hash);
     }
 }
 
 // -----------------------------------------------------------
-//  Logging entry point
+//  Writer pool
 // -----------------------------------------------------------
 
-bool PostgresDatabase::logData(const std::string& payload) {
-    if (!isConnected || !connection || !connection->is_open()) {
-        std::cerr << "Database not connected, cannot log data." << std::endl;
-        return false;
-    }
+// Connections are opened up front so a bad pool shows up at startup, not on the first frame
+bool PostgresDatabase::startWriters() {
+    const std::string payloadTable =
+        config["tables"]["payloads"]["name"].as<std::string>();
 
-    if (shouldRecheckSize()) {
-        isDatabaseTooLarge();
+    // writers racing on the same new image can deadlock on its primary key; PostgreSQL aborts
+    // one of them and that writer's per-frame retry gets through
+    std::vector<std::unique_ptr<PostgresWriter>> pool;
+    for (size_t i = 0; i < writer_connections; ++i) {
+        auto writer = std::make_unique<PostgresWriter>(connectionInfo, payloadTable, split_payload);
+        if (!writer->connect()) {
+            std::cerr << "[Postgres] Writer connection " << i << " failed" << std::endl;
+            return false;
+        }
+        pool.push_back(std::move(writer));
     }
 
-    if (db_too_large_cached) {
-        std::cerr << "[Postgres] Skipping log (database exceeds limit)\n";
-        return false;
+    // a couple of batches per writer can wait while the previous ones are in flight; beyond
+    // that logData blocks, which pushes back on the receive loop instead of growing memory
+    pending = std::make_unique<MpmcQueue<PendingFrame>>(writer_connections * pipeline_depth * 2);
+
+    for (size_t i = 0; i < pool.size(); ++i)
+        writers.emplace_back(&PostgresDatabase::writerLoop, this, i, std::move(pool[i]));
+
+    std::cout << "[Postgres] " << writers.size() << " writer connections in pipeline mode" << std::endl;
+    return true;
+}
+
+void PostgresDatabase::stopWriters() {
+    if (pending) pending->close();
+    for (auto& t : writers) t.join();
+    writers.clear();
+}
+
+void PostgresDatabase::writerLoop(size_t index, std::unique_ptr<PostgresWriter> writer) {
+    trace_thread_name("data_logger/writer " + std::to_string(index));
+
+    std::vector<PendingFrame> batch;
+    std::vector<WriteOutcome> outcomes;
+    batch.reserve(pipeline_depth);
+
+    while (true) {
+        batch.clear();
+        if (pending->popBatch(batch, pipeline_depth) == 0) break;   // closed and drained
+
+        {
+            // one span per pipeline segment, from the first frame sent to the commit
+            TraceSpan span("db commit", batch.front().header.image.frame_number,
+                           static_cast<uint32_t>(batch.size()));
+            writer->write(batch, outcomes);
+        }
+        if (split_payload) rememberImageHashes(batch, outcomes);
+        if (index) indexBatch(batch, outcomes);
+
+        size_t logged = 0, new_images = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!outcomes[i].ok) continue;
+            ++logged;
+
+            const PendingFrame& frame = batch[i];
+            const size_t image_bytes = frame.image_size;
+            if (retention) {
+                retention->accountRows(frame.features.size() * sizeof(float) + kRowOverheadBytes
+                                       + (split_payload ? 0 : sizeof(FeatureHeader) + image_bytes));
+                if (outcomes[i].image_inserted) retention->accountImage(image_bytes + kRowOverheadBytes);
+            }
+            if (outcomes[i].image_inserted) ++new_images;
+        }
+
+        std::cout << "[Writer " << index << "] Logged " << logged << "/" << batch.size()
+                  << " frames up to #" << batch.back().header.image.frame_number;
+        if (split_payload) std::cout << " (" << new_images << " new images)";
+        std::cout << std::endl;
+
+        // frames of a batch that hit a dead connection are lost, later ones go to a new one
+        if (!writer->connected()) {
+            std::cerr << "[Writer " << index << "] Connection lost, reconnecting" << std::endl;
+            writer->connect();
+        }
     }
+}
+
+// -----------------------------------------------------------
+//  Similarity index
+// -----------------------------------------------------------
+
+// Keyset-paged like loadKnownImageHashes. Rows come oldest first so each image ends up with its
+// newest frame number. Vectors the extractor reduced while shedding load are left out.
+void PostgresDatabase::loadFeatureIndex() {
+    using Bytes = std::basic_string<std::byte>;
+    constexpr size_t kBatch = 10000;
+    const auto started = std::chrono::steady_clock::now();
+    size_t rows = 0;
 
     try {
-        pqxx::work txn(*connection);
+        const auto& tables = config["tables"];
+        const char* table_key = split_payload ? "features" : "payloads";
+        if (!tables[table_key] || !tables[table_key]["enabled"].as<bool>()) return;
 
-        bool success = split_payload
-            ? logSplitPayload(txn, payload)
-            : logUnsplitPayload(txn, payload);
+        pqxx::work txn(*connection);
+        const std::string table = txn.quote_name(tables[table_key]["name"].as<std::string>());
+        long long last = 0;
+
+        // when each row was logged, so retention can later remove images along with their rows
+        const std::string logged = tables[table_key]["partition_by"]
+            ? "EXTRACT(EPOCH FROM " + txn.quote_name(tables[table_key]["partition_by"].as<std::string>())
+                  + ")::bigint"
+            : std::string("0");
+
+        // payloads are read as their header and trailing feature bytes, never the image; the
+        // feature count sits little-endian at a fixed offset of the header
+        const size_t count_at = offsetof(FeatureHeader, feature_count);
+        std::ostringstream feature_count;
+        feature_count << "(get_byte(payload_data, " << count_at << ")"
+                      << " + (get_byte(payload_data, " << count_at + 1 << ") << 8)"
+                      << " + (get_byte(payload_data, " << count_at + 2 << ") << 16)"
+                      << " + (get_byte(payload_data, " << count_at + 3 << ") << 24))";
+
+        while (true) {
+            std::ostringstream query;
+            if (split_payload) {
+                query << "SELECT id, image_hash, frame_number, feature_vector, " << logged << " FROM " << table
+                      << " WHERE id > " << last
+                      << " AND (shedding IS NULL OR shedding NOT LIKE '%skipped=%')";
+            } else {
+                query << "SELECT id, substring(payload_data FROM 1 FOR " << sizeof(FeatureHeader) << "), "
+                      << "substring(payload_data FROM octet_length(payload_data) - 4 * "
+                      << feature_count.str() << " + 1), " << logged << " FROM " << table
+                      << " WHERE id > " << last
+                      << " AND octet_length(payload_data) >= " << sizeof(FeatureHeader);
+            }
+            query << " ORDER BY id LIMIT " << kBatch << ";";
+
+            pqxx::result r = txn.exec(query.str());
+            for (const auto& row : r) {
+                last = row[0].as<long long>();
+                if (split_payload) {
+                    // a vector that is not whole floats was not written by this logger
+                    const Bytes features = row[3].as<Bytes>();
+                    if (features.empty() || features.size() % sizeof(float) != 0) continue;
+
+                    std::vector<float> vec(features.size() / sizeof(float));
+                    std::memcpy(vec.data(), features.data(), vec.size() * sizeof(float));
+                    index->add(static_cast<uint64_t>(row[1].as<long long>()), row[2].as<long long>(),
+                               vec.data(), vec.size(), row[4].as<long long>());
+                } else {
+                    const Bytes head = row[1].as<Bytes>();
+                    const Bytes features = row[2].as<Bytes>();
+                    FeatureHeader header;
+                    std::memcpy(&header, head.data(), sizeof(header));
+                    if (header.shed_flags || header.image.content_hash == 0
+                        || features.size() != size_t(header.feature_count) * sizeof(float))
+                        continue;
+
+                    std::vector<float> vec(header.feature_count);
+                    std::memcpy(vec.data(), features.data(), features.size());
+                    index->add(header.image.content_hash, header.image.frame_number, vec.data(), vec.size(),
+                               row[3].as<long long>());
+                }
+                ++rows;
+            }
 
-        if (success) {
-            txn.commit();
-            insert_counter++;
+            if (r.size() < kBatch) break;
         }
-        
-        return success;
 
+        txn.commit();
     } catch (const std::exception& e) {
-        std::cerr << "Data logging failed: " << e.what() << std::endl;
-        return false;
+        std::cerr << "[Index] Failed to load feature vectors: " << e.what() << std::endl;
+    }
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    std::cout << "[Index] Loaded " << rows << " feature vectors (" << index->size()
+              << " distinct images) in " << ms << " ms" << std::endl;
+}
+
+// Only committed frames, and only full vectors: a reduced one is not comparable
+void PostgresDatabase::indexBatch(const std::vector<PendingFrame>& batch,
+                                  const std::vector<WriteOutcome>& outcomes) {
+    // just after the commit, so never earlier than the rows' own timestamps
+    const int64_t logged_s = static_cast<int64_t>(std::time(nullptr));
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const PendingFrame& frame = batch[i];
+        if (!outcomes[i].ok || frame.header.shed_flags) continue;
+
+        const uint64_t hash = split_payload ? static_cast<uint64_t>(frame.image_hash)
+                                            : frame.header.image.content_hash;
+        if (hash == 0) continue;
+        index->add(hash, frame.header.image.frame_number, frame.features.data(), frame.features.size(),
+                   logged_s);
     }
 }
 
 // -----------------------------------------------------------
-//  Helper: split payload mode
+//  Logging entry point
 // -----------------------------------------------------------
-bool PostgresDatabase::logSplitPayload(pqxx::work& txn,
-                                       const std::string& payload) {
-    // Expect payload formatted as:  "<image>|<features>|<optional_model>"
-    std::istringstream ss(payload);
-    std::string image, features, model;
-    std::getline(ss, image, '|');
-    std::getline(ss, features, '|');
-    std::getline(ss, model, '|'); // may be empty
-
-    if (image.empty() || features.empty()) {
-        std::cerr << "Invalid split payload: must contain at least image and features." << std::endl;
+
+bool PostgresDatabase::logData(const FrameRecord& record) {
+    if (!isConnected || !pending) {
+        std::cerr << "Database not connected, cannot log data." << std::endl;
         return false;
     }
 
-    std::ostringstream imgQuery;
-    imgQuery << "INSERT INTO images (image_data, metadata) VALUES ("
-             << txn.quote(image) << ", NULL) RETURNING id;";
-    pqxx::result imgRes = txn.exec(imgQuery.str());
-    int image_id = imgRes[0][0].as<int>();
-
-    std::ostringstream featQuery;
-    featQuery << "INSERT INTO features (image_id, feature_vector, model_version) VALUES ("
-              << image_id << ", "
-              << txn.quote(features) << ", "
-              << (model.empty() ? "NULL" : txn.quote(model))
-              << ");";
-    txn.exec(featQuery.str());
+    PendingFrame frame;
+    frame.header = record.header;
+    frame.features.assign(record.features, record.features + record.feature_count);
 
-    std::cout << "Logged split payload [image_id=" << image_id
-              << "] image='" << image << "', features='" << features << "'"
-              << std::endl;
-    return true;
-}
+    if (split_payload) {
+        if (!record.image || record.image_size == 0) {
+            std::cerr << "Invalid split payload: frame carries no image data." << std::endl;
+            return false;
+        }
 
-// -----------------------------------------------------------
-//  Helper: unsplit payload mode
-// -----------------------------------------------------------
-bool PostgresDatabase::logUnsplitPayload(pqxx::work& txn,
-                                         const std::string& payload) {
-    const std::string payloadTable =
-        config["tables"]["payloads"]["name"].as<std::string>();
+        // images are keyed by the content hash computed at the source; records without one
+        // fall back to hashing the image bytes here
+        const uint64_t hash = record.header.image.content_hash != 0
+            ? record.header.image.content_hash
+            : content_hash(record.image, record.image_size);
+        frame.image_hash = static_cast<int64_t>(hash); // BIGINT is signed, keep the bits
+        frame.image_known = isKnownImageHash(frame.image_hash);
+    }
 
-    std::ostringstream query;
-    query << "INSERT INTO " << txn.esc(payloadTable)
-          << " (payload_data) VALUES (" << txn.quote(payload) << ");";
+    // shared, not copied, when the caller hands over ownership of the received buffer
+    if (record.image && record.image_owner) {
+        frame.image = record.image;
+        frame.image_owner = record.image_owner;
+    } else if (record.image) {
+        auto copy = std::make_shared<std::vector<uint8_t>>(record.image, record.image + record.image_size);
+        frame.image = copy->data();
+        frame.image_owner = std::move(copy);
+    }
+    frame.image_size = frame.image ? record.image_size : 0;
 
-    txn.exec(query.str());
-    std::cout << "Logged unsplit payload to '" << payloadTable
-              << "' (" << payload.size() << " chars)" << std::endl;
-    return true;
-}
\ No newline at end of file
+    return pending->push(std::move(frame));
+}
@@ -0,0 +1,243 @@
+#include "postgres_writer.hpp"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Human readable shape of the image, stored next to its bytes
+std::string describeImage(const ImageHeader& image) {
+    std::ostringstream out;
+    out << "size=" << image.width << "x" << image.height << "x" << image.channels
+        << ";format=" << image.pixel_format
+        << ";codec=" << codec_name(image.codec)
+        << ";bytes=" << image.pixel_count;
+    return out.str();
+}
+
+std::string modelVersion(const FeatureHeader& header) {
+    return std::string(header.model_version,
+                       strnlen(header.model_version, sizeof(header.model_version)));
+}
+
+} // namespace
+
+PostgresWriter::PostgresWriter(std::string connection_info, std::string payload_table,
+                               bool split_payload)
+    : connectionInfo(std::move(connection_info)),
+      payloadTable(std::move(payload_table)),
+      split_payload(split_payload) {}
+
+PostgresWriter::~PostgresWriter() {
+    if (conn) PQfinish(conn);
+}
+
+bool PostgresWriter::connected() const {
+    return conn && PQstatus(conn) == CONNECTION_OK;
+}
+
+void PostgresWriter::reportError(const char* what) const {
+    std::cerr << "[Writer] " << what << ": " << (conn ? PQerrorMessage(conn) : "no connection")
+              << std::endl;
+}
+
+bool PostgresWriter::connect() {
+    if (conn) PQfinish(conn);
+    conn = PQconnectdb(connectionInfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        reportError("Connection failed");
+        return false;
+    }
+
+    // prepared before entering pipeline mode, where PQprepare is not allowed
+    const std::string escaped_table = [&] {
+        char* quoted = PQescapeIdentifier(conn, payloadTable.c_str(), payloadTable.size());
+        std::string out = quoted ? quoted : payloadTable;
+        PQfreemem(quoted);
+        return out;
+    }();
+
+    const std::pair<const char*, std::string> statements[] = {
+        {"insert_image",
+         "INSERT INTO images (content_hash, image_data, metadata) VALUES ($1, $2, $3) "
+         "ON CONFLICT (content_hash) DO NOTHING"},
+        {"insert_feature",
+         "INSERT INTO features (image_hash, frame_number, feature_vector, model_version, shedding) "
+         "VALUES ($1, $2, $3, $4, $5)"},
+        // concatenated by the server, so the image is bound straight from its buffer
+        {"insert_payload",
+         "INSERT INTO " + escaped_table + " (payload_data) VALUES ($1::bytea || $2::bytea || $3::bytea)"},
+    };
+
+    for (const auto& [name, sql] : statements) {
+        PGresult* res = PQprepare(conn, name, sql.c_str(), 0, nullptr);
+        const bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        PQclear(res);
+        if (!ok) {
+            reportError(name);
+            return false;
+        }
+    }
+
+    if (!PQenterPipelineMode(conn)) {
+        reportError("Entering pipeline mode failed");
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------
+//  Sending
+// -----------------------------------------------------------
+
+bool PostgresWriter::sendSplit(const PendingFrame& frame, bool& sent_image, size_t& statements) {
+    const std::string hash = std::to_string(frame.image_hash);
+
+    sent_image = !frame.image_known;
+    if (sent_image) {
+        const std::string metadata = describeImage(frame.header.image);
+        const char* values[3] = {hash.c_str(),
+                                 reinterpret_cast<const char*>(frame.image),
+                                 metadata.c_str()};
+        const int lengths[3] = {0, static_cast<int>(frame.image_size), 0};
+        const int formats[3] = {0, 1, 0};   // BYTEA as raw bytes
+
+        if (!PQsendQueryPrepared(conn, "insert_image", 3, values, lengths, formats, 0))
+            return false;
+        ++statements;
+    }
+
+    // float32 values in host byte order; every supported platform is little-endian
+    const std::string frame_number = std::to_string(frame.header.image.frame_number);
+    const std::string model = modelVersion(frame.header);
+    const std::string shedding = describe_shedding(frame.header);
+    const char* values[5] = {hash.c_str(),
+                             frame_number.c_str(),
+                             reinterpret_cast<const char*>(frame.features.data()),
+                             model.empty() ? nullptr : model.c_str(),
+                             shedding.empty() ? nullptr : shedding.c_str()};
+    const int lengths[5] = {0, 0, static_cast<int>(frame.features.size() * sizeof(float)), 0, 0};
+    const int formats[5] = {0, 0, 1, 0, 0};
+
+    if (!PQsendQueryPrepared(conn, "insert_feature", 5, values, lengths, formats, 0))
+        return false;
+    ++statements;
+    return true;
+}
+
+bool PostgresWriter::sendUnsplit(const PendingFrame& frame, size_t& statements) {
+    // the message parts back to back: FeatureHeader | image bytes | float32 features
+    static const char kEmpty = 0;
+    const char* values[3] = {reinterpret_cast<const char*>(&frame.header),
+                             frame.image ? reinterpret_cast<const char*>(frame.image) : &kEmpty,
+                             frame.features.empty() ? &kEmpty
+                                                    : reinterpret_cast<const char*>(frame.features.data())};
+    const int lengths[3] = {static_cast<int>(sizeof(FeatureHeader)),
+                            static_cast<int>(frame.image_size),
+                            static_cast<int>(frame.features.size() * sizeof(float))};
+    const int formats[3] = {1, 1, 1};
+
+    if (!PQsendQueryPrepared(conn, "insert_payload", 3, values, lengths, formats, 0))
+        return false;
+    ++statements;
+    return true;
+}
+
+bool PostgresWriter::sendFrame(const PendingFrame& frame, bool& sent_image, size_t& statements) {
+    statements = 0;
+    sent_image = false;
+    return split_payload ? sendSplit(frame, sent_image, statements)
+                         : sendUnsplit(frame, statements);
+}
+
+// -----------------------------------------------------------
+//  Batches
+// -----------------------------------------------------------
+
+bool PostgresWriter::writeSegment(const std::vector<PendingFrame>& batch, size_t first, size_t last,
+                                  std::vector<WriteOutcome>& outcomes) {
+    // everything between two sync points runs as one implicit transaction
+    std::vector<size_t> statements(last - first, 0);
+    std::vector<bool> sent_image(last - first, false);
+    bool send_ok = true;
+
+    for (size_t i = first; i < last && send_ok; ++i) {
+        bool image = false;
+        send_ok = sendFrame(batch[i], image, statements[i - first]);
+        sent_image[i - first] = image;
+    }
+    if (!send_ok) reportError("Sending batch failed");
+
+    if (!PQpipelineSync(conn)) {
+        reportError("Pipeline sync failed");
+        return false;
+    }
+
+    // one reply (followed by a NULL) per statement, then the sync marker
+    bool segment_ok = send_ok;
+    for (size_t i = first; i < last; ++i) {
+        WriteOutcome& outcome = outcomes[i];
+        outcome = WriteOutcome{};
+
+        for (size_t s = 0; s < statements[i - first]; ++s) {
+            PGresult* res = PQgetResult(conn);
+            const ExecStatusType status = PQresultStatus(res);
+
+            if (status != PGRES_COMMAND_OK) {
+                const char* state = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+                outcome.image_missing = state && std::strcmp(state, "23503") == 0;
+                if (status != PGRES_PIPELINE_ABORTED && !outcome.image_missing)
+                    std::cerr << "[Writer] Frame #" << batch[i].header.image.frame_number
+                              << " failed: " << PQresultErrorMessage(res);
+                segment_ok = false;
+            } else if (s == 0 && sent_image[i - first]) {
+                outcome.image_inserted = std::strcmp(PQcmdTuples(res), "0") != 0;
+            }
+            PQclear(res);
+
+            // each statement's results end with a NULL
+            while (PGresult* extra = PQgetResult(conn)) PQclear(extra);
+        }
+    }
+
+    PGresult* sync = PQgetResult(conn);
+    if (PQresultStatus(sync) != PGRES_PIPELINE_SYNC) {
+        reportError("Pipeline lost sync");
+        segment_ok = false;
+    }
+    PQclear(sync);
+
+    for (size_t i = first; i < last; ++i) {
+        outcomes[i].ok = segment_ok;
+        if (!segment_ok) outcomes[i].image_inserted = false;
+    }
+    return segment_ok;
+}
+
+void PostgresWriter::write(const std::vector<PendingFrame>& batch, std::vector<WriteOutcome>& outcomes) {
+    outcomes.assign(batch.size(), WriteOutcome{});
+    if (batch.empty() || !connected()) return;
+
+    // if the batch was rolled back as a whole, isolate the frame(s) that caused it
+    if (!writeSegment(batch, 0, batch.size(), outcomes) && batch.size() > 1) {
+        for (size_t i = 0; i < batch.size(); ++i)
+            writeSegment(batch, i, i + 1, outcomes);
+    }
+
+    // retention pruned the image after the frame was queued as known; its bytes are still
+    // held, so insert the image again along with the frame
+    for (size_t i = 0; i < batch.size() && connected(); ++i) {
+        if (outcomes[i].ok || !outcomes[i].image_missing || !batch[i].image_known || !batch[i].image)
+            continue;
+
+        std::vector<PendingFrame> retry{batch[i]};
+        retry[0].image_known = false;
+        std::vector<WriteOutcome> retried(1);
+        writeSegment(retry, 0, 1, retried);
+        outcomes[i] = retried[0];
+
+        if (!outcomes[i].ok)
+            std::cerr << "[Writer] Frame #" << batch[i].header.image.frame_number
+                      << " failed: its image was pruned and could not be stored again" << std::endl;
+    }
+}
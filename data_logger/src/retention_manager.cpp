@@ -0,0 +1,369 @@
+#include "retention_manager.hpp"
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+RetentionManager::RetentionManager(const std::string& connection_info,
+                                   std::vector<std::string> partitioned_tables,
+                                   std::string images_table,
+                                   std::string features_table,
+                                   RetentionConfig config)
+    : connectionInfo(connection_info),
+      tables(std::move(partitioned_tables)),
+      imagesTable(std::move(images_table)),
+      featuresTable(std::move(features_table)),
+      cfg(config) {
+    if (cfg.partition_interval_s <= 0) cfg.partition_interval_s = 3600;
+    if (cfg.check_period_s <= 0) cfg.check_period_s = 30;
+}
+
+RetentionManager::~RetentionManager() {
+    stop();
+}
+
+bool RetentionManager::start() {
+    try {
+        connection = std::make_unique<pqxx::connection>(connectionInfo);
+        measureExisting();
+        ensurePartitions(static_cast<long long>(std::time(nullptr)));
+    } catch (const std::exception& e) {
+        std::cerr << "[Retention] Startup failed: " << e.what() << std::endl;
+        return false;
+    }
+
+    std::cout << "[Retention] " << buckets.size() << " partition interval(s), "
+              << (totalBytes() / (1024 * 1024)) << " MB of "
+              << (cfg.max_bytes / (1024 * 1024)) << " MB in use" << std::endl;
+
+    worker = std::thread(&RetentionManager::run, this);
+    return true;
+}
+
+void RetentionManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void RetentionManager::run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping) {
+        wake.wait_for(lock, std::chrono::seconds(cfg.check_period_s), [&] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        try {
+            tick();
+        } catch (const std::exception& e) {
+            std::cerr << "[Retention] " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+void RetentionManager::tick() {
+    const long long now_s = static_cast<long long>(std::time(nullptr));
+    const long long current = intervalStart(now_s);
+
+    ensurePartitions(now_s);
+
+    // rows land in the partition for the database's clock; attributing a tick's worth of
+    // bytes to the current interval is only off around interval boundaries, and closed
+    // intervals are measured exactly below anyway
+    buckets[current].bytes += static_cast<long long>(unflushed_row_bytes.exchange(0));
+    images_bytes += static_cast<long long>(unflushed_image_bytes.exchange(0));
+
+    measureClosedBuckets(current);
+    enforceLimit(current);
+}
+
+// -----------------------------------------------------------
+//  Partition bookkeeping
+// -----------------------------------------------------------
+
+long long RetentionManager::intervalStart(long long unix_s) const {
+    return unix_s - (unix_s % cfg.partition_interval_s);
+}
+
+// <table>_pYYYYMMDD_HHMMSS in UTC, so names sort in time order
+std::string RetentionManager::partitionName(const std::string& table, long long start_s) const {
+    const std::time_t t = static_cast<std::time_t>(start_s);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+
+    std::ostringstream name;
+    name << table << "_p" << std::put_time(&tm, "%Y%m%d_%H%M%S");
+    return name.str();
+}
+
+static std::string utcLiteral(long long unix_s) {
+    const std::time_t t = static_cast<std::time_t>(unix_s);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+
+    std::ostringstream out;
+    out << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "+00";
+    return out.str();
+}
+
+long long RetentionManager::relationSize(pqxx::work& txn, const std::string& relation) {
+    pqxx::result r = txn.exec(
+        "SELECT COALESCE(pg_total_relation_size(to_regclass(" + txn.quote(relation) + ")), 0);");
+    return r[0][0].as<long long>();
+}
+
+// Reverses partitionName(); false for default partitions and tables we did not create
+bool RetentionManager::parsePartitionStart(const std::string& table, const std::string& name,
+                                           long long& start) const {
+    const std::string prefix = table + "_p";
+    if (name.compare(0, prefix.size(), prefix) != 0) return false;
+
+    std::tm tm{};
+    std::istringstream ts(name.substr(prefix.size()));
+    ts >> std::get_time(&tm, "%Y%m%d_%H%M%S");
+    if (ts.fail()) return false;
+
+    start = static_cast<long long>(timegm(&tm));
+    return true;
+}
+
+long long RetentionManager::totalBytes() const {
+    long long total = base_bytes + images_bytes + detachedBytes();
+    for (const auto& [start, bucket] : buckets) total += bucket.bytes;
+    return total;
+}
+
+long long RetentionManager::detachedBytes() const {
+    long long total = 0;
+    for (const auto& [start, bucket] : detached) total += bucket.bytes;
+    return total;
+}
+
+// One-off measurement at startup; after this the logger only counts what it writes
+void RetentionManager::measureExisting() {
+    const long long current = intervalStart(static_cast<long long>(std::time(nullptr)));
+    pqxx::work txn(*connection);
+
+    if (!imagesTable.empty()) images_bytes = relationSize(txn, imagesTable);
+
+    for (const auto& table : tables) {
+        pqxx::result r = txn.exec(
+            "SELECT c.relname, pg_total_relation_size(c.oid) "
+            "FROM pg_inherits i "
+            "JOIN pg_class c ON c.oid = i.inhrelid "
+            "JOIN pg_class p ON p.oid = i.inhparent "
+            "WHERE p.relname = " + txn.quote(table) + ";");
+
+        for (const auto& row : r) {
+            const std::string name = row[0].as<std::string>();
+            const long long bytes = row[1].as<long long>();
+
+            long long start = 0;
+            if (!parsePartitionStart(table, name, start)) {
+                base_bytes += bytes; // default partition or one we did not create
+                continue;
+            }
+
+            Bucket& bucket = buckets[start];
+            bucket.bytes += bytes;
+            // intervals still open keep growing and get measured again once they close
+            bucket.measured = start < current;
+        }
+
+        // partitions detached by an earlier run that nobody has archived yet
+        r = txn.exec(
+            "SELECT c.relname, pg_total_relation_size(c.oid) "
+            "FROM pg_class c "
+            "WHERE c.relkind = 'r' AND c.relname LIKE " + txn.quote(table + "_p%") + " "
+            "AND NOT EXISTS (SELECT 1 FROM pg_inherits i WHERE i.inhrelid = c.oid);");
+
+        for (const auto& row : r) {
+            long long start = 0;
+            if (!parsePartitionStart(table, row[0].as<std::string>(), start)) continue;
+
+            Bucket& bucket = detached[start];
+            bucket.bytes += row[1].as<long long>();
+            bucket.measured = true;
+        }
+    }
+
+    txn.commit();
+}
+
+// Keeps the current and the next interval's partitions in place ahead of the clock
+void RetentionManager::ensurePartitions(long long now_s) {
+    const long long current = intervalStart(now_s);
+
+    for (long long start : {current, current + cfg.partition_interval_s}) {
+        if (buckets.count(start)) continue;
+
+        pqxx::work txn(*connection);
+        for (const auto& table : tables) {
+            std::ostringstream ddl;
+            ddl << "CREATE TABLE IF NOT EXISTS " << txn.quote_name(partitionName(table, start))
+                << " PARTITION OF " << txn.quote_name(table)
+                << " FOR VALUES FROM (" << txn.quote(utcLiteral(start))
+                << ") TO (" << txn.quote(utcLiteral(start + cfg.partition_interval_s)) << ");";
+            txn.exec(ddl.str());
+        }
+        txn.commit();
+
+        buckets[start];
+        std::cout << "[Retention] Created partitions for " << utcLiteral(start) << std::endl;
+    }
+}
+
+// Replaces the running estimate of every interval that has closed with its real size
+void RetentionManager::measureClosedBuckets(long long current_start) {
+    pqxx::work txn(*connection);
+    for (auto& [start, bucket] : buckets) {
+        if (start >= current_start || bucket.measured) continue;
+
+        long long bytes = 0;
+        for (const auto& table : tables) bytes += relationSize(txn, partitionName(table, start));
+        bucket.bytes = bytes;
+        bucket.measured = true;
+    }
+    txn.commit();
+}
+
+// -----------------------------------------------------------
+//  Size limit
+// -----------------------------------------------------------
+
+void RetentionManager::enforceLimit(long long current_start) {
+    // images referenced only by archived partitions can go now, and a prune a writer
+    // raced with last tick is tried again
+    if (reapDetached() || prune_pending)
+        images_bytes = std::max(0LL, images_bytes - pruneOrphanImages());
+
+    bool removed_any = false;
+    long long pruned_bytes = 0;
+
+    // detached partitions still take space, but detaching more would not return any of it
+    while (totalBytes() - detachedBytes() > cfg.max_bytes && !buckets.empty()
+           && buckets.begin()->first < current_start) {
+        const long long oldest = buckets.begin()->first;
+
+        pqxx::work txn(*connection);
+        for (const auto& table : tables) {
+            const std::string part = partitionName(table, oldest);
+            if (cfg.action == RetentionAction::Drop) {
+                txn.exec("DROP TABLE IF EXISTS " + txn.quote_name(part) + ";");
+            } else {
+                txn.exec("ALTER TABLE " + txn.quote_name(table)
+                         + " DETACH PARTITION " + txn.quote_name(part) + ";");
+            }
+        }
+        txn.commit();
+
+        std::cout << "[Retention] " << (cfg.action == RetentionAction::Drop ? "Dropped" : "Detached")
+                  << " partitions for " << utcLiteral(oldest) << " ("
+                  << (buckets.begin()->second.bytes / (1024 * 1024)) << " MB)" << std::endl;
+
+        if (cfg.action == RetentionAction::Detach) detached[oldest] = buckets.begin()->second;
+        buckets.erase(buckets.begin());
+        removed_any = true;
+        if (interval_removed) interval_removed(oldest + cfg.partition_interval_s);
+
+        // images shared with newer intervals stay; the rest count against the limit before
+        // the next interval is considered. Detached rows keep their images referenced.
+        if (cfg.action == RetentionAction::Drop) {
+            const long long bytes = pruneOrphanImages();
+            images_bytes = std::max(0LL, images_bytes - bytes);
+            pruned_bytes += bytes;
+        }
+    }
+
+    // a DELETE leaves dead tuples behind; make their space reusable for new images
+    if (pruned_bytes > 0) {
+        pqxx::nontransaction vacuum(*connection);
+        vacuum.exec("VACUUM " + vacuum.quote_name(imagesTable) + ";");
+    }
+
+    if (totalBytes() > cfg.max_bytes && !removed_any) {
+        if (!detached.empty()) {
+            std::cerr << "[Retention] " << (totalBytes() / (1024 * 1024)) << " MB in use exceeds the limit, "
+                      << (detachedBytes() / (1024 * 1024)) << " MB of it in " << detached.size()
+                      << " detached interval(s) waiting to be archived and dropped" << std::endl;
+        } else {
+            std::cerr << "[Retention] " << (totalBytes() / (1024 * 1024))
+                      << " MB in use exceeds the limit, but only the current interval is left"
+                      << std::endl;
+        }
+    }
+}
+
+// Forgets detached intervals whose tables an operator has since dropped. True if any went.
+bool RetentionManager::reapDetached() {
+    if (detached.empty()) return false;
+
+    bool reaped = false;
+    pqxx::work txn(*connection);
+    for (auto it = detached.begin(); it != detached.end();) {
+        long long bytes = 0;
+        for (const auto& table : tables) bytes += relationSize(txn, partitionName(table, it->first));
+
+        if (bytes == 0) {
+            std::cout << "[Retention] Detached partitions for " << utcLiteral(it->first)
+                      << " are gone" << std::endl;
+            it = detached.erase(it);
+            reaped = true;
+        } else {
+            it->second.bytes = bytes;
+            ++it;
+        }
+    }
+    txn.commit();
+    return reaped;
+}
+
+// Images are content-addressed and shared across intervals, so they are only removed
+// once no remaining feature row references them, detached partitions included. Returns
+// the bytes the deleted rows took: the table file does not shrink until a VACUUM FULL, but
+// a plain VACUUM lets new images reuse the space, so this is what the budget gains.
+//
+// The foreign key has no ON DELETE action: a writer that references an image again while
+// it is being pruned makes the whole DELETE fail instead of losing its row, and the prune
+// is retried on the next tick.
+long long RetentionManager::pruneOrphanImages() {
+    prune_pending = false;
+    if (imagesTable.empty()) return 0;
+    if (std::find(tables.begin(), tables.end(), featuresTable) == tables.end()) return 0;
+
+    pqxx::work txn(*connection);
+    std::string query = "DELETE FROM " + txn.quote_name(imagesTable) + " AS i "
+        "WHERE NOT EXISTS (SELECT 1 FROM " + txn.quote_name(featuresTable) + " AS f "
+        "WHERE f.image_hash = i.content_hash)";
+    for (const auto& [start, bucket] : detached) {
+        query += " AND NOT EXISTS (SELECT 1 FROM " + txn.quote_name(partitionName(featuresTable, start))
+               + " AS f WHERE f.image_hash = i.content_hash)";
+    }
+    query += " RETURNING pg_column_size(i.*);";
+
+    pqxx::result r;
+    try {
+        r = txn.exec(query);
+        txn.commit();
+    } catch (const pqxx::foreign_key_violation&) {
+        std::cout << "[Retention] An image being pruned was logged again, retrying next check"
+                  << std::endl;
+        prune_pending = true;
+        return 0;
+    }
+
+    long long bytes = 0;
+    for (const auto& row : r) bytes += row[0].as<long long>();
+
+    if (!r.empty()) {
+        images_pruned_epoch.fetch_add(1, std::memory_order_release);
+        std::cout << "[Retention] Removed " << r.size() << " unreferenced images ("
+                  << (bytes / (1024 * 1024)) << " MB)" << std::endl;
+    }
+    return bytes;
+}
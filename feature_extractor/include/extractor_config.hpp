@@ -0,0 +1,24 @@
+// feature_extractor section of configs/pipeline/config.yml
+#pragma once
+#include "pipeline_config.hpp"
+#include <cstddef>
+#include <string>
+
+// feature_extractor.load_shedding: when frames arrive faster than they can be extracted
+struct SheddingConfig {
+    bool enabled = true;
+    uint32_t latency_budget_ms = 250;   // allowed frame age, sending to extraction start
+    double queue_high = 0.75;           // job queue fill that counts as falling behind
+    uint32_t max_stride = 8;            // at the last level only 1 of every max_stride frames is extracted
+    uint32_t step_up_ms = 100;          // minimum time between two escalations
+    uint32_t step_down_ms = 1000;       // time within budget needed before each recovery step
+};
+
+struct ExtractorConfig {
+    size_t num_workers = 0;         // 0 = one per CPU the stage may run on
+    size_t cache_entries = 4096;    // content_hash -> features results kept, 0 disables the cache
+    SheddingConfig shedding;
+};
+
+// Missing file or keys keep the defaults above
+ExtractorConfig loadExtractorConfig(const std::string& path = kPipelineConfigPath);
@@ -0,0 +1,10 @@
+// Entry point of the feature_extractor stage, shared by its own binary and the single-process pipeline
+#pragma once
+#include "pipeline_config.hpp"
+#include <cstddef>
+#include <zmq.hpp>
+
+// Receives frames on the image endpoint, extracts features on num_workers threads (0 = the
+// configured count) and sends the results on the features endpoint until ShutdownHandler
+// reports shutdown. Returns the process exit code.
+int runFeatureExtractor(zmq::context_t& ctx, const TransportConfig& transport, size_t num_workers);
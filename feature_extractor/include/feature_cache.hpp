@@ -0,0 +1,73 @@
+// Bounded content_hash -> features cache. The generator loops over the same folder forever,
+// so once every image has been seen, workers answer from here without decoding anything.
+#pragma once
+#include "message_headers.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct CachedFeatures {
+    // decoded shape, so encoded frames served from the cache still report their dimensions
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = 0;
+    uint32_t pixel_format = 0;
+    std::vector<float> features;
+};
+
+// What a result depends on: the payload bytes and how the header says to interpret them.
+// Raw frames with the same bytes but another shape or format must not share features.
+struct FeatureCacheKey {
+    uint64_t content_hash;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixel_format;
+    uint32_t codec;
+
+    bool operator==(const FeatureCacheKey& o) const {
+        return content_hash == o.content_hash && width == o.width && height == o.height
+            && pixel_format == o.pixel_format && codec == o.codec;
+    }
+};
+
+// Taken from the header as received, before decoding fills in an encoded frame's shape
+inline FeatureCacheKey feature_cache_key(const ImageHeader& header) {
+    return {header.content_hash, header.width, header.height, header.pixel_format, header.codec};
+}
+
+struct FeatureCacheKeyHash {
+    size_t operator()(const FeatureCacheKey& k) const {
+        // content_hash is already well mixed, fold the small fields into it
+        uint64_t h = k.content_hash;
+        for (uint64_t v : {uint64_t(k.width) << 32 | k.height, uint64_t(k.pixel_format) << 32 | k.codec})
+            h = (h ^ v) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+};
+
+// Least-recently-used eviction, safe to share between worker threads
+class FeatureCache {
+public:
+    explicit FeatureCache(size_t capacity);
+
+    // Copies the entry into out and marks it most recently used. False on a miss.
+    bool lookup(const FeatureCacheKey& key, CachedFeatures& out);
+
+    void insert(const FeatureCacheKey& key, CachedFeatures entry);
+
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    using Entry = std::pair<FeatureCacheKey, CachedFeatures>;
+
+    const size_t capacity;
+    mutable std::mutex mtx;
+    std::list<Entry> lru;       // front = most recently used
+    std::unordered_map<FeatureCacheKey, std::list<Entry>::iterator, FeatureCacheKeyHash> index;
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+};
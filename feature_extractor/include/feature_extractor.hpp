@@ -1,6 +1,22 @@
 #pragma once
 
+#include "message_headers.hpp"
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <opencv2/core.hpp>
 
-std::string extractFeatures(const std::string& input);
+// version tag logged next to every feature vector
+inline constexpr const char* kFeatureModelVersion = "stats-v2";
 
+// Turns a received payload into pixels. Raw frames are wrapped without copying, encoded
+// frames are decoded and their width/height/channels/pixel_format written back into header.
+bool decodeFrame(ImageHeader& header, const uint8_t* data, size_t size, cv::Mat& out);
+
+// Per-channel mean/stddev followed by a normalized grayscale histogram. The histogram costs
+// two more passes over the pixels and is left out while shedding load.
+std::vector<float> extractFeatures(const cv::Mat& image, bool with_histogram = true);
+
+// Header of the result message sent to the data_logger for this frame
+FeatureHeader makeFeatureHeader(const ImageHeader& header, size_t feature_count);
@@ -0,0 +1,55 @@
+// Degrades extraction one level at a time while the extractor falls behind its latency
+// budget, and recovers the same way once it keeps up again:
+//   level 0     everything extracted
+//   level 1     grayscale histogram skipped, channel statistics only
+//   level 2..n  histogram skipped and only every 2nd, 4th, ... max_stride-th frame extracted
+// Dropping at the receiver keeps the job queue short, so the frames that are extracted stay
+// fresh instead of waiting behind a backlog.
+#pragma once
+#include "extractor_config.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+class LoadShedder {
+public:
+    explicit LoadShedder(const SheddingConfig& config);
+
+    // Called by a worker as it picks up a frame: how old the frame is and how many jobs are
+    // still waiting behind it. Moves the level by at most one step.
+    void observe(uint64_t frame_age_ns, size_t queued, size_t capacity);
+
+    uint32_t level() const { return current.load(std::memory_order_relaxed); }
+    bool skipHistogram() const { return level() >= 1; }
+
+    // 1 of every stride() frames is extracted at the current level
+    uint32_t stride() const { return strideAt(level()); }
+
+    // Receiver thread only: false for a frame to drop at the current stride
+    bool admit();
+
+    void countReduced() { reduced.fetch_add(1, std::memory_order_relaxed); }
+
+    uint64_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+    uint64_t reducedFrames() const { return reduced.load(std::memory_order_relaxed); }
+    uint32_t peakLevel() const { return peak.load(std::memory_order_relaxed); }
+
+private:
+    uint32_t strideAt(uint32_t lvl) const;
+    void setLevel(uint32_t lvl, uint64_t now_ns, uint64_t frame_age_ns, size_t queued, size_t capacity);
+
+    const SheddingConfig config;
+    const uint32_t max_level;
+
+    std::atomic<uint32_t> current{0};
+    std::atomic<uint32_t> peak{0};
+    std::atomic<uint64_t> dropped_count{0};
+    std::atomic<uint64_t> reduced{0};
+
+    uint64_t received = 0;          // receiver thread only
+
+    std::mutex mtx;                 // guards the timing state of the level changes
+    uint64_t last_change_ns = 0;
+    uint64_t healthy_since_ns = 0;  // 0 while over half the budget
+};
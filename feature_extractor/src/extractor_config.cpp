@@ -0,0 +1,35 @@
+#include "extractor_config.hpp"
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <iostream>
+
+ExtractorConfig loadExtractorConfig(const std::string& path) {
+    ExtractorConfig cfg;
+
+    YAML::Node root;
+    try {
+        root = YAML::LoadFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Failed to load extractor config from " << path
+                  << " (" << e.what() << "), using defaults\n";
+        return cfg;
+    }
+
+    const auto& fe = root["feature_extractor"];
+    if (!fe) return cfg;
+
+    if (fe["num_workers"])   cfg.num_workers = fe["num_workers"].as<size_t>();
+    if (fe["cache_entries"]) cfg.cache_entries = fe["cache_entries"].as<size_t>();
+
+    if (const auto& ls = fe["load_shedding"]) {
+        SheddingConfig& sh = cfg.shedding;
+        if (ls["enabled"])           sh.enabled = ls["enabled"].as<bool>();
+        if (ls["latency_budget_ms"]) sh.latency_budget_ms = ls["latency_budget_ms"].as<uint32_t>();
+        if (ls["queue_high"])        sh.queue_high = ls["queue_high"].as<double>();
+        if (ls["max_stride"])        sh.max_stride = std::max(1u, ls["max_stride"].as<uint32_t>());
+        if (ls["step_up_ms"])        sh.step_up_ms = ls["step_up_ms"].as<uint32_t>();
+        if (ls["step_down_ms"])      sh.step_down_ms = ls["step_down_ms"].as<uint32_t>();
+    }
+
+    return cfg;
+}
@@ -0,0 +1,297 @@
+#include "extractor_stage.hpp"
+#include "shared.hpp"
+#include "shutdown_handler.hpp"
+#include "message_headers.hpp"
+#include "feature_extractor.hpp"
+#include "ring_queue.hpp"
+#include "feature_cache.hpp"
+#include "extractor_config.hpp"
+#include "load_shedder.hpp"
+#include "transport.hpp"
+#include "pixel_kernels.hpp"
+#include "runtime_profile.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+// This host's monotonic clock; the generator's timestamps come from another host's wall clock
+static uint64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Turns the generator's wall-clock timestamps into this host's steady clock without any
+// clock sync. (steady receipt - timestamp) is the transit time plus an unknown but fixed
+// offset between the clocks; its minimum comes from a frame that crossed with no backlog,
+// so whatever a frame spends above it was spent queued, in zmq's buffers included. The
+// minimum is taken over the current and the previous window, so a step of the generator's
+// clock is forgotten after at most two windows. Receiver thread only.
+class SendClock {
+public:
+    // When the frame was sent, on steadyNowNs()'s clock
+    uint64_t sentAt(uint64_t timestamp_ns, uint64_t received_ns) {
+        const int64_t offset = static_cast<int64_t>(received_ns - timestamp_ns);
+        if (received_ns - window_start_ns >= kWindowNs) {
+            previous_min = current_min;
+            current_min = offset;
+            window_start_ns = received_ns;
+        } else {
+            current_min = std::min(current_min, offset);
+        }
+        return timestamp_ns + static_cast<uint64_t>(std::min(previous_min, current_min));
+    }
+
+private:
+    static constexpr uint64_t kWindowNs = 60'000'000'000ull;
+
+    uint64_t window_start_ns = 0;
+    int64_t current_min = std::numeric_limits<int64_t>::max();
+    int64_t previous_min = std::numeric_limits<int64_t>::max();
+};
+
+// A received frame waiting for a worker. The payload message keeps ownership of the
+// bytes zmq received, so raw frames are processed without another copy.
+struct FrameJob {
+    ImageHeader header;
+    zmq::message_t payload;
+    uint64_t sent_ns = 0;       // when the generator sent it, on steadyNowNs()'s clock
+    uint32_t frames_shed = 0;   // frames the receiver dropped just before this one
+};
+
+// Features for one frame on their way to the sender. The image bytes travel on to the
+// logger in the same zmq message they arrived in.
+struct FrameResult {
+    FeatureHeader header;
+    zmq::message_t image;
+    std::vector<float> features;
+};
+
+// Decodes (when the generator runs with --encoded) and extracts features for each job.
+// Frames whose content was seen before are answered from the cache without decoding.
+static void workerLoop(size_t index, MpmcQueue<FrameJob>& jobs, MpmcQueue<FrameResult>& results,
+                       FeatureCache& cache, LoadShedder& shedder) {
+    trace_thread_name("feature_extractor/worker " + std::to_string(index));
+
+    FrameJob job;
+    while (jobs.pop(job)) {
+        const uint64_t frame = job.header.frame_number;
+
+        // time since it was sent, zmq's receive buffer and this job queue included
+        shedder.observe(steadyNowNs() - job.sent_ns, jobs.size(), jobs.capacity());
+        const uint32_t shed_level = shedder.level();
+        uint32_t shed_flags = 0;
+
+        // a zero hash means the producer did not hash the frame, so there is nothing to key on
+        const bool cacheable = job.header.content_hash != 0;
+        const FeatureCacheKey key = feature_cache_key(job.header);
+
+        CachedFeatures entry;
+        if (!cacheable || !cache.lookup(key, entry)) {
+            const bool with_histogram = !shedder.skipHistogram();
+
+            // frames can come from any peer; one OpenCV rejects drops that frame, not the worker
+            try {
+                cv::Mat image;
+                {
+                    TraceSpan span("decode", frame);
+                    if (!decodeFrame(job.header, static_cast<const uint8_t*>(job.payload.data()),
+                                     job.payload.size(), image))
+                        continue;
+                }
+                {
+                    TraceSpan span("extract", frame);
+                    entry.features = extractFeatures(image, with_histogram);
+                }
+            } catch (const cv::Exception& e) {
+                std::cerr << "[WARN] Dropping frame #" << frame << ": " << e.what() << "\n";
+                continue;
+            }
+
+            entry.width = job.header.width;
+            entry.height = job.header.height;
+            entry.channels = job.header.channels;
+            entry.pixel_format = job.header.pixel_format;
+
+            // reduced vectors are not cached, a later hit would hand them out at full load
+            if (!with_histogram) {
+                shed_flags |= ShedHistogram;
+                shedder.countReduced();
+            } else if (cacheable) {
+                cache.insert(key, entry);
+            }
+        } else {
+            job.header.width = entry.width;
+            job.header.height = entry.height;
+            job.header.channels = entry.channels;
+            job.header.pixel_format = entry.pixel_format;
+        }
+
+        FrameResult result;
+        result.header = makeFeatureHeader(job.header, entry.features.size());
+        result.header.shed_level = shed_level;
+        result.header.shed_flags = shed_flags;
+        result.header.frames_shed = job.frames_shed;
+        result.image = std::move(job.payload);
+        result.features = std::move(entry.features);
+        if (!results.push(std::move(result)))
+            break;
+    }
+}
+
+// Owns the publisher socket; zmq sockets must only be used from one thread
+static void senderLoop(zmq::context_t& ctx, const TransportConfig& transport,
+                       MpmcQueue<FrameResult>& results, bool busy_poll) {
+    // pubsub binds the features endpoint, pushpull connects to the logger that bound it
+    zmq::socket_t publisher = makeFeatureSender(ctx, transport);
+    trace_thread_name("feature_extractor/sender");
+
+    // PUSH blocks while the logger is away, so wake up regularly to notice shutdown
+    publisher.set(zmq::sockopt::sndtimeo, 100);
+    publisher.set(zmq::sockopt::linger, 0);
+
+    FrameResult result;
+    while (results.pop(result)) {
+        std::cout << "Processed frame #" << result.header.image.frame_number << " ("
+                  << result.header.feature_count << " features)" << std::endl;
+        TraceSpan span("publish", result.header.image.frame_number);
+        try {
+            // ---- Frame 0: header ----
+            // retried until accepted; once the first part is queued the rest of the message is too
+            bool queued = false;
+            while (!queued && ShutdownHandler::running())
+                queued = sendFirstPart(publisher, zmq::buffer(&result.header, sizeof(FeatureHeader)),
+                                       busy_poll);
+            if (!queued) continue;
+
+            // ---- Frame 1: image bytes, handed over without copying ----
+            publisher.send(result.image, zmq::send_flags::sndmore);
+            // ---- Frame 2: float32 feature vector ----
+            publisher.send(zmq::buffer(result.features), zmq::send_flags::none);
+        } catch (const zmq::error_t& e) {
+            if (e.num() != EINTR) std::cerr << "ZMQ error: " << e.what() << std::endl;
+        }
+    }
+}
+
+int runFeatureExtractor(zmq::context_t& ctx, const TransportConfig& transport, size_t num_workers) {
+    print_banner("Feature Extractor Started");
+
+    // before any thread starts: workers and the sender inherit CPUs and memory policy
+    const RuntimeProfile profile = loadRuntimeProfile("feature_extractor");
+    applyRuntimeProfile("feature_extractor", profile);
+    pinIoThreads(ctx, profile.cpus);
+
+    TraceSession tracing("feature_extractor");
+    trace_thread_name("feature_extractor/receiver");
+
+    const ExtractorConfig config = loadExtractorConfig();
+
+    // decoding dominates for encoded frames, so default to one worker per core we may run on
+    if (num_workers == 0) num_workers = config.num_workers;
+    if (num_workers == 0) num_workers = usable_cpu_count();
+
+    FeatureCache cache(config.cache_entries);
+    LoadShedder shedder(config.shedding);
+
+    // Connect to the endpoint the image generator bound to. In pushpull mode any number of
+    // extractors can run side by side, each getting a share
+    zmq::socket_t subscriber = makeImageReceiver(ctx, transport);
+
+    // wake up periodically so shutdown is noticed even when no frames arrive
+    subscriber.set(zmq::sockopt::rcvtimeo, 100);
+
+    // a couple of frames per worker keeps everyone busy without buffering stale frames
+    MpmcQueue<FrameJob> jobs(num_workers * 2);
+    MpmcQueue<FrameResult> results(num_workers * 2);
+
+    std::thread sender(senderLoop, std::ref(ctx), std::cref(transport), std::ref(results),
+                       profile.busy_poll);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_workers; ++i)
+        workers.emplace_back(workerLoop, i, std::ref(jobs), std::ref(results), std::ref(cache),
+                             std::ref(shedder));
+
+    // only the receiver is latency-critical; workers and the sender stay time-sliced
+    applyRealtimePriority("feature_extractor/receiver", profile);
+
+    std::cout << "Listening for messages on " << transport.image_endpoint
+              << " (" << transport_mode_name(transport.mode) << ") with "
+              << num_workers << " workers (" << simd_level_name(active_simd_level())
+              << " pixel kernels) ..." << std::endl;
+    if (config.shedding.enabled)
+        std::cout << "Shedding load beyond " << config.shedding.latency_budget_ms << " ms frame age or "
+                  << config.shedding.queue_high * 100 << "% queue fill" << std::endl;
+
+    // dropped by the shedder since the last frame handed to a worker
+    uint32_t frames_shed = 0;
+    SendClock send_clock;
+
+    try {
+        while (ShutdownHandler::running()) {
+            // ---- Frame 0: header ----
+            zmq::message_t header_msg;
+            if (!recvFirstPart(subscriber, header_msg, profile.busy_poll))
+                continue; // timed out
+
+            if (!header_msg.more() || header_msg.size() != sizeof(ImageHeader)) {
+                std::cerr << "[WARN] Dropping malformed message (" << header_msg.size() << " bytes)\n";
+                while (subscriber.get(zmq::sockopt::rcvmore)) {
+                    zmq::message_t rest;
+                    (void)subscriber.recv(rest, zmq::recv_flags::none);
+                }
+                continue;
+            }
+
+            FrameJob job;
+            std::memcpy(&job.header, header_msg.data(), sizeof(ImageHeader));
+            job.sent_ns = send_clock.sentAt(job.header.timestamp_ns, steadyNowNs());
+
+            const uint64_t frame = job.header.frame_number;
+
+            {
+                TraceSpan span("receive", frame);
+                // ---- Frame 1: pixel bytes (raw pixels or encoded file bytes) ----
+                if (!subscriber.recv(job.payload, zmq::recv_flags::none))
+                    continue;
+            }
+
+            // dropped after receiving, so the socket is never left mid-message
+            if (!shedder.admit()) {
+                ++frames_shed;
+                continue;
+            }
+            job.frames_shed = frames_shed;
+            frames_shed = 0;
+
+            // blocks while every worker is busy and the job queue is full
+            TraceSpan span("enqueue", frame);
+            if (!jobs.push(std::move(job)))
+                break;
+        }
+    }
+    catch (const zmq::error_t& e) {
+        if (!ShutdownHandler::running() && e.num() == EINTR) {
+            // Interrupted by a shutdown signal — normal exit
+        } else {
+            std::cerr << "ZMQ error: " << e.what() << std::endl;
+        }
+    }
+
+    // drain: workers finish what was queued, then the sender publishes their results
+    jobs.close();
+    for (auto& w : workers) w.join();
+    results.close();
+    sender.join();
+
+    std::cout << "Feature cache: " << cache.hits() << " hits, " << cache.misses() << " misses\n";
+    std::cout << "Load shedding: " << shedder.dropped() << " frames dropped, " << shedder.reducedFrames()
+              << " without histogram, peak level " << shedder.peakLevel() << "\n";
+
+    print_banner("Feature Extractor Terminated");
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "feature_cache.hpp"
+
+FeatureCache::FeatureCache(size_t capacity) : capacity(capacity) {
+    index.reserve(capacity);
+}
+
+bool FeatureCache::lookup(const FeatureCacheKey& key, CachedFeatures& out) {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++miss_count;
+        return false;
+    }
+
+    lru.splice(lru.begin(), lru, it->second);
+    out = it->second->second;
+    ++hit_count;
+    return true;
+}
+
+void FeatureCache::insert(const FeatureCacheKey& key, CachedFeatures entry) {
+    if (capacity == 0) return;
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        // another worker raced us to the same frame; keep one copy
+        lru.splice(lru.begin(), lru, it->second);
+        return;
+    }
+
+    if (lru.size() >= capacity) {
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+
+    lru.emplace_front(key, std::move(entry));
+    index.emplace(key, lru.begin());
+}
+
+size_t FeatureCache::hits() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return hit_count;
+}
+
+size_t FeatureCache::misses() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return miss_count;
+}
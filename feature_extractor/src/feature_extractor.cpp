@@ -1,5 +1,127 @@
 #include "feature_extractor.hpp"
+#include "pixel_kernels.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <iostream>
+#include <cstring>
 
-std::string extractFeatures(const std::string& input) {
-    return "Extracted features from: " + input;
+namespace {
+
+constexpr int kHistogramBins = 16;
+
+// Grayscale histogram through the runtime-dispatched lib/ kernels
+void kernelHistogram(const PixelKernels& kernels, const cv::Mat& image, std::vector<float>& features) {
+    const size_t pixels = image.total();
+    std::vector<uint8_t> gray(pixels * kernels.depth_bytes);
+    kernels.to_gray(image.data, gray.data(), pixels);
+
+    uint32_t bins[256];
+    kernels.histogram(gray.data(), pixels, bins);
+
+    constexpr int fold = 256 / kHistogramBins;
+    for (int b = 0; b < kHistogramBins; ++b) {
+        uint32_t count = 0;
+        for (int i = 0; i < fold; ++i) count += bins[b * fold + i];
+        features.push_back(static_cast<float>(count) / static_cast<float>(pixels));
+    }
+}
+
+// Same histogram through OpenCV, for layouts the kernels do not cover (e.g. float images)
+void opencvHistogram(const cv::Mat& image, std::vector<float>& features) {
+    cv::Mat gray;
+    if (image.channels() == 3)      cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    else if (image.channels() == 4) cv::cvtColor(image, gray, cv::COLOR_BGRA2GRAY);
+    else                            cv::extractChannel(image, gray, 0);
+
+    // calcHist only takes 8U, 16U and 32F
+    if (gray.depth() != CV_8U && gray.depth() != CV_16U && gray.depth() != CV_32F)
+        gray.convertTo(gray, CV_32F);
+
+    const int channel = 0;
+    const int bins = kHistogramBins;
+    const float range_max = image.depth() == CV_16U ? 65536.0f : 256.0f;
+    const float range[] = {0.0f, range_max};
+    const float* ranges[] = {range};
+
+    cv::Mat hist;
+    cv::calcHist(&gray, 1, &channel, cv::Mat(), hist, 1, &bins, ranges);
+
+    const float total = static_cast<float>(gray.total());
+    for (int b = 0; b < kHistogramBins; ++b)
+        features.push_back(hist.at<float>(b) / total);
+}
+
+} // namespace
+
+bool decodeFrame(ImageHeader& header, const uint8_t* data, size_t size, cv::Mat& out) {
+    if (header.codec == static_cast<uint32_t>(ImageCodec::Raw)) {
+        cv::Mat raw(static_cast<int>(header.height), static_cast<int>(header.width),
+                    static_cast<int>(header.pixel_format), const_cast<uint8_t*>(data));
+        if (raw.total() * raw.elemSize() != size) {
+            std::cerr << "[WARN] Frame #" << header.frame_number << " size mismatch: header says "
+                      << raw.total() * raw.elemSize() << " bytes, got " << size << "\n";
+            return false;
+        }
+        out = raw;
+        return true;
+    }
+
+    // cv::imdecode asserts on an empty buffer
+    if (size == 0) {
+        std::cerr << "[WARN] Empty " << codec_name(header.codec)
+                  << " frame #" << header.frame_number << "\n";
+        return false;
+    }
+
+    // cv::imdecode only reads from the buffer, the wrapper never owns it
+    cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t*>(data));
+    out = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+    if (out.empty()) {
+        std::cerr << "[WARN] Failed to decode " << codec_name(header.codec)
+                  << " frame #" << header.frame_number << "\n";
+        return false;
+    }
+
+    header.width = out.cols;
+    header.height = out.rows;
+    header.channels = out.channels();
+    header.pixel_format = out.type();
+    return true;
+}
+
+std::vector<float> extractFeatures(const cv::Mat& image, bool with_histogram) {
+    std::vector<float> features;
+    if (image.empty()) return features;
+
+    // scale every depth into [0, 1] so 8 and 16 bit sources are comparable
+    const double scale = image.depth() == CV_16U ? 1.0 / 65535.0 : 1.0 / 255.0;
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(image, mean, stddev);
+    for (int c = 0; c < image.channels(); ++c) {
+        features.push_back(static_cast<float>(mean[c] * scale));
+        features.push_back(static_cast<float>(stddev[c] * scale));
+    }
+
+    if (!with_histogram) return features;
+
+    // every full vector has the same layout: the histogram is never silently left out
+    const PixelKernels* kernels = pixel_kernels(static_cast<uint32_t>(image.type()));
+    if (!kernels) {
+        opencvHistogram(image, features);
+    } else if (!image.isContinuous()) {
+        kernelHistogram(*kernels, image.clone(), features);
+    } else {
+        kernelHistogram(*kernels, image, features);
+    }
+
+    return features;
+}
+
+FeatureHeader makeFeatureHeader(const ImageHeader& header, size_t feature_count) {
+    FeatureHeader out{};
+    out.image = header;
+    out.feature_count = static_cast<uint32_t>(feature_count);
+    std::strncpy(out.model_version, kFeatureModelVersion, sizeof(out.model_version) - 1);
+    return out;
 }
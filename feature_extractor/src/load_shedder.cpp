@@ -0,0 +1,79 @@
+#include "load_shedder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+uint64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+constexpr uint64_t kNsPerMs = 1000000;
+
+} // namespace
+
+LoadShedder::LoadShedder(const SheddingConfig& config)
+    : config(config),
+      max_level([&] {
+          // level 1 drops the histogram, each level after it doubles the stride up to max_stride
+          uint32_t lvl = 1;
+          for (uint32_t stride = 1; stride < config.max_stride; stride <<= 1) ++lvl;
+          return lvl;
+      }()) {}
+
+uint32_t LoadShedder::strideAt(uint32_t lvl) const {
+    if (lvl < 2) return 1;
+    return std::min(config.max_stride, 1u << (lvl - 1));
+}
+
+bool LoadShedder::admit() {
+    const uint32_t s = stride();
+    if (s <= 1 || received++ % s == 0) return true;
+    dropped_count.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void LoadShedder::observe(uint64_t frame_age_ns, size_t queued, size_t capacity) {
+    if (!config.enabled) return;
+
+    const uint64_t budget_ns = uint64_t(config.latency_budget_ms) * kNsPerMs;
+    const double fill = capacity ? double(queued) / double(capacity) : 0.0;
+
+    // recovering needs a clear margin, so the level does not flap around the budget
+    const bool over = frame_age_ns > budget_ns || fill >= config.queue_high;
+    const bool healthy = frame_age_ns <= budget_ns / 2 && fill < config.queue_high / 2;
+
+    const uint64_t now = steady_now_ns();
+    std::lock_guard<std::mutex> lock(mtx);
+    const uint32_t lvl = level();
+
+    if (over) {
+        healthy_since_ns = 0;
+        if (lvl < max_level && now - last_change_ns >= config.step_up_ms * kNsPerMs)
+            setLevel(lvl + 1, now, frame_age_ns, queued, capacity);
+    } else if (healthy) {
+        if (healthy_since_ns == 0) healthy_since_ns = now;
+        const uint64_t step_down_ns = config.step_down_ms * kNsPerMs;
+        if (lvl > 0 && now - healthy_since_ns >= step_down_ns && now - last_change_ns >= step_down_ns) {
+            setLevel(lvl - 1, now, frame_age_ns, queued, capacity);
+            healthy_since_ns = now;
+        }
+    } else {
+        healthy_since_ns = 0;
+    }
+}
+
+void LoadShedder::setLevel(uint32_t lvl, uint64_t now_ns, uint64_t frame_age_ns, size_t queued,
+                           size_t capacity) {
+    std::cout << "[Shedding] level " << level() << " -> " << lvl << ": "
+              << (lvl == 0 ? "full extraction" : "histogram skipped");
+    if (strideAt(lvl) > 1) std::cout << ", 1 of " << strideAt(lvl) << " frames extracted";
+    std::cout << " (frame age " << frame_age_ns / kNsPerMs << " ms, queue " << queued << "/"
+              << capacity << ")" << std::endl;
+
+    current.store(lvl, std::memory_order_relaxed);
+    if (lvl > peak.load(std::memory_order_relaxed)) peak.store(lvl, std::memory_order_relaxed);
+    last_change_ns = now_ns;
+}
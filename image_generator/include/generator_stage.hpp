@@ -0,0 +1,15 @@
+// Entry point of the image_generator stage, shared by its own binary and the single-process pipeline
+#pragma once
+#include "pipeline_config.hpp"
+#include <string>
+#include <zmq.hpp>
+
+struct GeneratorOptions {
+    std::string folder;
+    bool encoded = false;   // ship the original file bytes instead of decoded pixels
+};
+
+// Reads the folder in a loop and sends every image on the image endpoint until
+// ShutdownHandler reports shutdown. Returns the process exit code.
+int runImageGenerator(zmq::context_t& ctx, const TransportConfig& transport,
+                      const GeneratorOptions& options);
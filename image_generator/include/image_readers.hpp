@@ -41,9 +41,30 @@ public:
     bool load(const std::string &filepath, std::vector<uint8_t> &outPixels, ImageHeader &header) const override;
 };
 
+// Pass-through reader: ships the original, still-compressed file bytes and leaves decoding
+// to the feature_extractor workers. Only the codec is known up front; width, height,
+// channels and pixel_format stay 0 until the receiver decodes the frame.
+class EncodedImageReader: public ImageReader {
+public:
+    bool can_read(const std::string &filepath) const override;
+
+    // always fails: an encoded reader has no decoded pixel shape to report
+    bool load(const std::string &filepath,
+              std::vector<uint8_t> &outPixels,
+              uint32_t &w, uint32_t &h, uint32_t &c,
+              uint32_t &pixel_format) const override;
+
+    // load the file bytes and codec into an ImageHeader for sending
+    bool load(const std::string &filepath, std::vector<uint8_t> &outPixels, ImageHeader &header) const override;
+
+    // maps a file extension onto the codec of its contents, Raw if unknown
+    static ImageCodec codec_for(const std::string &filepath);
+};
+
 class ImageReaderFactory {
 public:
-    ImageReaderFactory();
+    // encoded = true prefers the pass-through reader over decoding at the source
+    explicit ImageReaderFactory(bool encoded = false);
 
     const ImageReader* get_reader(const std::string &filepath) const;
 
@@ -0,0 +1,158 @@
+#include "generator_stage.hpp"
+#include "shared.hpp"
+#include "shutdown_handler.hpp"
+#include "message_headers.hpp"
+#include "image_generator.hpp"
+#include "image_readers.hpp"
+#include "transport.hpp"
+#include "content_hash.hpp"
+#include "runtime_profile.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <vector>
+
+// Wraps a loaded image in a zmq message that takes over the vector instead of copying it.
+// zmq frees it once the last receiver is done, so over inproc:// the extractor and logger
+// see the very bytes the reader produced.
+static zmq::message_t adoptPixels(std::vector<uint8_t>&& pixels) {
+    auto* owned = new std::vector<uint8_t>(std::move(pixels));
+    return zmq::message_t(owned->data(), owned->size(),
+                          [](void*, void* hint) { delete static_cast<std::vector<uint8_t>*>(hint); },
+                          owned);
+}
+
+// Read an arbitrary number of images from a specified location then package and
+// send the image data via IPC to 
+
+// Image data should be published continuously until the application is stopped. If all
+// images from the input folder have been published, loop over the folder again…
+// forever 
+
+// The app should be able to handle images of varying sizes and resolutions (e.g. few
+// KB to >30MB)
+int runImageGenerator(zmq::context_t& ctx, const TransportConfig& transport,
+                      const GeneratorOptions& options) {
+    print_banner("Image Generator Started");
+
+    fs::path path(options.folder);
+
+    if (!fs::exists(path) || !fs::is_directory(path)) {
+        std::cerr << "Error: path does not exist or is not a directory.\n";
+        return 1;
+    }
+
+    std::filesystem::directory_iterator dir_iterator(path);
+
+    if (dir_iterator == fs::end(dir_iterator)) {
+        std::cout << "directory is empty.\n";
+        return 0;
+    }
+
+    // placement first: image buffers are allocated under the profile's memory policy, and
+    // zmq's I/O thread only picks up its CPUs before the first socket exists
+    const RuntimeProfile profile = loadRuntimeProfile("image_generator");
+    applyRuntimeProfile("image_generator", profile);
+    pinIoThreads(ctx, profile.cpus);
+
+    TraceSession tracing("image_generator");
+    trace_thread_name("image_generator/reader");
+
+    // Setup image handler 
+    ImageReaderFactory factory(options.encoded);
+    std::cout << "Publishing " << (options.encoded ? "encoded file bytes" : "decoded pixels") << "\n";
+
+    // ZeroMQ for easy ICP customization, abstraction.
+    // pubsub fans every frame out to every extractor, pushpull load-balances frames across
+    // however many extractors are connected (ipc:// on one host, tcp:// across hosts,
+    // inproc:// inside the single-process pipeline)
+    zmq::socket_t sender = makeImageSender(ctx, transport);
+
+    // PUSH blocks while no extractor has room, so wake up regularly to notice shutdown
+    sender.set(zmq::sockopt::sndtimeo, 100);
+    sender.set(zmq::sockopt::linger, 0);
+
+    // the reader publishes every frame itself, so it is the thread that gets SCHED_FIFO
+    applyRealtimePriority("image_generator/reader", profile);
+
+    std::cout << "Publishing on " << transport.image_endpoint
+              << " (" << transport_mode_name(transport.mode) << ")\n";
+
+    // keeps track of how many frames have been read
+    uint64_t frame_count = 0;
+
+    try {
+        // Publishes all the images to the zmq topic, and once all of them have been published loops over them again
+        while (ShutdownHandler::running()) {
+
+            // iterate over entire directory, creating a new iterator with each new loop.
+            for (const auto& entry : std::filesystem::directory_iterator(path)) {
+
+                if(!ShutdownHandler::running()) break;
+
+                if (!entry.is_regular_file())
+                    continue;
+
+                std::string filepath = entry.path().string();
+                const ImageReader* reader = factory.get_reader(filepath);
+
+                if (!reader) {
+                    std::cerr << "[WARN] No reader for " << filepath << "\n";
+                    continue;
+                }
+
+                ImageHeader header{};
+                std::vector<uint8_t> pixels;
+
+                {
+                    TraceSpan span("read", frame_count);
+
+                    // loads image info and pixels into header and pixel vector
+                    if (!reader->load(filepath, pixels, header)) {
+                        std::cerr << "[WARN] Failed to load: " << filepath << "\n";
+                        continue;
+                    }
+
+                    // identical bytes on every pass over the folder give the same hash, which lets the
+                    // extractor reuse earlier results instead of re-extracting looped images
+                    header.content_hash = content_hash(pixels.data(), pixels.size());
+                }
+
+                header.timestamp_ns = get_timestamp_ns_utc();
+
+                header.frame_number = frame_count++;
+
+                if(!ShutdownHandler::running()) break;
+
+                std::cout << "Loaded image #" << header.frame_number << " ("
+                        << header.width << "x" << header.height << ", of type " << header.pixel_format
+                        << ", codec " << codec_name(header.codec) << ", " << header.pixel_count << " bytes"
+                        << ", hash " << content_hash_hex(header.content_hash)
+                        << " at time " << header.timestamp_ns << ")\n";
+            
+                // publish the image header and pixels via ZeroMQ, using a multipart message.
+                // using a multipart message minimizes buffer allocations and copies. Also allows streaming.
+                TraceSpan span("publish", header.frame_number);
+                // ---- Frame 0: header ----
+                // retried until accepted; once the first part is queued the rest of the message is too
+                bool queued = false;
+                while (!queued && ShutdownHandler::running())
+                    queued = sendFirstPart(sender, zmq::buffer(&header, sizeof(header)), profile.busy_poll);
+                if (!queued) break;
+                // ---- Frame 1: pixel bytes (raw pixels or encoded file bytes, see header.codec) ----
+                sender.send(adoptPixels(std::move(pixels)), zmq::send_flags::none);
+            }
+
+        }
+    }
+    catch (const zmq::error_t& e) {
+        if (!ShutdownHandler::running() && e.num() == EINTR) {
+            // Interrupted by a shutdown signal — normal exit
+        } else {
+            std::cerr << "ZMQ error: " << e.what() << std::endl;
+        }
+    }
+
+    print_banner("Image Generator Terminated");
+
+    return 0;
+}
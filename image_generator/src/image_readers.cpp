@@ -3,6 +3,10 @@
 #include "image_readers.hpp"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgcodecs.hpp>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
 
 // Returns true if OpenCV can read the file, false if not
 bool OpenCVImageReader::can_read(const std::string &filepath) const {
@@ -26,14 +30,76 @@ bool OpenCVImageReader::load(const std::string &filepath,
     c = img.channels();
     pixel_format = img.type();
 
-    outPixels.assign(img.data, img.data + img.total() * c);
+    outPixels.assign(img.data, img.data + img.total() * img.elemSize());
     return true;
 }
 
 // load image metadata directly into an ImageHeader for sending
 bool OpenCVImageReader::load(const std::string &filepath, std::vector<uint8_t> &outPixels, ImageHeader &header) const 
 {
-    return load(filepath, outPixels, header.width, header.height, header.channels, header.pixel_format);
+    if (!load(filepath, outPixels, header.width, header.height, header.channels, header.pixel_format))
+        return false;
+
+    header.codec = static_cast<uint32_t>(ImageCodec::Raw);
+    header.pixel_count = outPixels.size();
+    return true;
+}
+
+// Returns true if the extension maps onto a codec the extractor knows how to decode
+bool EncodedImageReader::can_read(const std::string &filepath) const {
+    return codec_for(filepath) != ImageCodec::Raw;
+}
+
+bool EncodedImageReader::load(const std::string &filepath,
+              std::vector<uint8_t> &,
+              uint32_t &, uint32_t &, uint32_t &,
+              uint32_t &) const
+{
+    std::cerr << "[ERROR] Encoded reader cannot report a pixel shape for: " << filepath << "\n";
+    return false;
+}
+
+// Reads the whole file into memory without decoding it
+bool EncodedImageReader::load(const std::string &filepath, std::vector<uint8_t> &outPixels, ImageHeader &header) const
+{
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "[ERROR] Failed to open image: " << filepath << "\n";
+        return false;
+    }
+
+    const std::streamsize size = file.tellg();
+    if (size <= 0) {
+        std::cerr << "[ERROR] Empty image: " << filepath << "\n";
+        return false;
+    }
+    file.seekg(0, std::ios::beg);
+
+    outPixels.resize(static_cast<size_t>(size));
+    if (!file.read(reinterpret_cast<char*>(outPixels.data()), size)) {
+        std::cerr << "[ERROR] Failed to read image: " << filepath << "\n";
+        return false;
+    }
+
+    header.width = 0;
+    header.height = 0;
+    header.channels = 0;
+    header.pixel_format = 0;
+    header.codec = static_cast<uint32_t>(codec_for(filepath));
+    header.pixel_count = outPixels.size();
+    return true;
+}
+
+ImageCodec EncodedImageReader::codec_for(const std::string &filepath) {
+    std::string ext = std::filesystem::path(filepath).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char ch) { return std::tolower(ch); });
+
+    if (ext == ".png")                   return ImageCodec::Png;
+    if (ext == ".jpg" || ext == ".jpeg") return ImageCodec::Jpeg;
+    if (ext == ".bmp")                   return ImageCodec::Bmp;
+    if (ext == ".tif" || ext == ".tiff") return ImageCodec::Tiff;
+    return ImageCodec::Raw;
 }
 
 // handler factory implementation
@@ -45,6 +111,10 @@ const ImageReader* ImageReaderFactory::get_reader(const std::string &filepath) c
     return nullptr;
 }
 
-ImageReaderFactory::ImageReaderFactory() {
+ImageReaderFactory::ImageReaderFactory(bool encoded) {
+        // readers are tried in order, so the pass-through reader wins when enabled and
+        // OpenCV still picks up any format the extractor could not decode itself
+        if (encoded)
+            readers.emplace_back(std::make_unique<EncodedImageReader>());
         readers.emplace_back(std::make_unique<OpenCVImageReader>());
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+// Fast non-cryptographic content hash used to recognise frames that were already seen
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// xxHash64 of the buffer. Four independent 64-bit lanes consume 32 bytes per step,
+// so throughput is bound by memory bandwidth rather than multiply latency.
+uint64_t content_hash(const void* data, size_t size, uint64_t seed = 0);
+
+// 16 lowercase hex digits, the form used in logged records and the database
+std::string content_hash_hex(uint64_t hash);
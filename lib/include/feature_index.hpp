@@ -0,0 +1,83 @@
+// In-memory IVF (inverted file) index over logged feature vectors, with one entry per
+// distinct image content hash. Every frame of an image has the same features, so logging
+// the image again only updates its entry's frame count and newest frame number.
+//
+// Vectors are grouped around k-means centroids, giving up to `lists` lists. A query only
+// scans the `probes` lists whose centroids are closest, using the SIMD kernels from
+// vector_kernels.hpp, so its cost grows with N * probes / lists instead of N. Clustering
+// happens once enough vectors have been added, and again each time the index has grown
+// kRetrainGrowth times since. It runs on a background thread over a snapshot, so adds and
+// searches carry on meanwhile and only the swap of the new lists is exclusive. Vectors of
+// different lengths (gray vs. color images) are kept in separate spaces and only compared
+// with queries of the same length. Images whose rows retention removed from the database
+// are removed here too (removeLoggedBefore).
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct IndexMatch {
+    uint64_t image_hash;
+    uint64_t last_frame;    // newest frame logged with this image
+    uint32_t frames;        // frames of this image added since the index was built
+    float distance;         // squared L2
+};
+
+// Safe to share: adds are exclusive, searches run concurrently
+class FeatureIndex {
+public:
+    FeatureIndex(size_t lists, size_t probes);
+    ~FeatureIndex();
+
+    FeatureIndex(const FeatureIndex&) = delete;
+    FeatureIndex& operator=(const FeatureIndex&) = delete;
+
+    // logged_s: unix seconds the frame was stored at, the newest one is kept per image
+    void add(uint64_t image_hash, uint64_t frame_number, const float* features, size_t dims,
+             int64_t logged_s);
+
+    // Drops an image's entry, false if it was not indexed
+    bool remove(uint64_t image_hash);
+
+    // Drops every image last logged before unix_s; returns how many
+    size_t removeLoggedBefore(int64_t unix_s);
+
+    // The k nearest images to query, closest first. probes = 0 uses the constructor's value.
+    std::vector<IndexMatch> search(const float* query, size_t dims, size_t k, size_t probes = 0) const;
+
+    // Copies an image's indexed vector, false if the image is not indexed
+    bool vectorOf(uint64_t image_hash, std::vector<float>& out) const;
+
+    // distinct images indexed
+    size_t size() const;
+
+    // Blocks until a running background clustering has been swapped in (tools, benchmarks)
+    void waitForTraining();
+
+    static constexpr size_t kRetrainGrowth = 8;
+
+private:
+    struct Space;
+
+    Space& spaceFor(size_t dims);
+    bool trainingDue(const Space& space) const;
+    void trainLoop(Space* space);
+    void erase(Space& space, uint32_t id);
+
+    const size_t max_lists;
+    const size_t default_probes;
+
+    mutable std::shared_mutex mtx;
+    std::unordered_map<size_t, std::unique_ptr<Space>> spaces;     // by vector length
+    size_t count = 0;
+
+    // one space is clustered at a time, by trainer
+    std::thread trainer;
+    const Space* training = nullptr;
+    std::atomic<bool> stopping{false};
+};
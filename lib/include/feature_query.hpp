@@ -0,0 +1,45 @@
+// Wire format of similarity queries answered by the data_logger (feature_index.hpp), served
+// on the similarity_index.endpoint of its config with a REQ/REP socket.
+//
+// Request, two parts:  FeatureQuery | dims float32 values (empty to query by image_hash)
+// Reply, two parts:    FeatureQueryReply | count FeatureQueryMatch entries, nearest first
+#pragma once
+#include <cstdint>
+
+enum class FeatureQueryStatus : uint32_t {
+    Ok           = 0,
+    Malformed    = 1,   // wrong part sizes
+    UnknownImage = 2,   // no indexed vector for image_hash
+};
+
+inline const char* query_status_name(uint32_t status) {
+    switch (static_cast<FeatureQueryStatus>(status)) {
+    case FeatureQueryStatus::Ok:           return "ok";
+    case FeatureQueryStatus::Malformed:    return "malformed request";
+    case FeatureQueryStatus::UnknownImage: return "image not indexed";
+    }
+    return "unknown";
+}
+
+#pragma pack(push, 1)
+struct FeatureQuery {
+    uint32_t k;                 // matches wanted
+    uint32_t probes;            // lists scanned, 0 = the logger's default
+    uint64_t image_hash;        // used when no vector is sent: query with this image's features
+    uint32_t dims;              // float32 values in the second part
+};
+
+struct FeatureQueryMatch {
+    uint64_t image_hash;        // content hash, the images table key
+    uint64_t last_frame;        // newest frame logged with this image
+    uint32_t frames;            // frames logged with this image since the logger started
+    float distance;             // squared L2
+};
+
+struct FeatureQueryReply {
+    uint32_t status;            // FeatureQueryStatus
+    uint32_t count;             // FeatureQueryMatch entries in the second part
+    uint64_t indexed;           // distinct images in the index
+    uint64_t search_us;
+};
+#pragma pack(pop)
@@ -1,18 +1,75 @@
 //declares an ImageMessage class to send image messages in a standard format
 #pragma once
 #include <vector>
+#include <cstdint>
+#include <string>
 
-// ### Struct for packaging image messages before sending them over IPC. 
+// ### Encoding of the bytes that follow an ImageHeader.
+// Raw means decoded pixels laid out as width*height*channels (OpenCV Mat order).
+// Every other value means the original, still-compressed file bytes; the receiver
+// is responsible for decoding them and filling in the image dimensions.
+enum class ImageCodec : uint32_t {
+    Raw  = 0,
+    Png  = 1,
+    Jpeg = 2,
+    Bmp  = 3,
+    Tiff = 4,
+};
+
+inline const char* codec_name(uint32_t codec) {
+    switch (static_cast<ImageCodec>(codec)) {
+    case ImageCodec::Raw:  return "raw";
+    case ImageCodec::Png:  return "png";
+    case ImageCodec::Jpeg: return "jpeg";
+    case ImageCodec::Bmp:  return "bmp";
+    case ImageCodec::Tiff: return "tiff";
+    }
+    return "unknown";
+}
+
+// ### Struct for packaging image messages before sending them over IPC.
 // we use pragma pack(push, 1) to line up the struct members contiguously in memory, without padding.
 // This allows us to send the struct using a binary protocol (fast)
 #pragma pack(push, 1)
 struct ImageHeader {
-    uint32_t width;
-    uint32_t height;
-    uint32_t channels;
+    uint32_t width;             // 0 for encoded frames until decoded
+    uint32_t height;            // 0 for encoded frames until decoded
+    uint32_t channels;          // 0 for encoded frames until decoded
     uint32_t pixel_format;      // e.g. RGB8, GRAY8
+    uint32_t codec;             // ImageCodec of the bytes following the header
     uint64_t frame_number;
     uint64_t timestamp_ns;
     uint64_t pixel_count;       // number of bytes following the header
+    uint64_t content_hash;      // content_hash() of the bytes following the header
+};
+#pragma pack(pop)
+
+// ### Struct heading every feature_extractor -> data_logger message.
+// The message is multipart: this header, then the image bytes exactly as the generator sent
+// them (image.pixel_count bytes, see image.codec), then feature_count float32 values in host
+// byte order. The same three parts concatenated are what the logger stores as one payload.
+#pragma pack(push, 1)
+struct FeatureHeader {
+    ImageHeader image;          // decoded width/height/channels/pixel_format filled in
+    uint32_t feature_count;     // number of float32 values in the last part
+    char model_version[16];     // NUL padded name of the feature extraction model
+    uint32_t shed_level;        // extractor load shedding level when the frame was processed, 0 = none
+    uint32_t shed_flags;        // ShedFlag bits: features left out of this frame
+    uint32_t frames_shed;       // frames the extractor dropped unprocessed since its previous result
+};
+#pragma pack(pop)
+
+// ### Features the feature_extractor left out of a frame while shedding load.
+enum ShedFlag : uint32_t {
+    ShedHistogram = 1u << 0,    // grayscale histogram skipped, only channel statistics extracted
 };
-#pragma pack(pop)
\ No newline at end of file
+
+// "level=2;skipped=histogram;dropped_before=3", empty for a frame that lost nothing
+inline std::string describe_shedding(const FeatureHeader& header) {
+    if (header.shed_level == 0 && header.shed_flags == 0 && header.frames_shed == 0) return {};
+
+    std::string out = "level=" + std::to_string(header.shed_level);
+    if (header.shed_flags & ShedHistogram) out += ";skipped=histogram";
+    if (header.frames_shed) out += ";dropped_before=" + std::to_string(header.frames_shed);
+    return out;
+}
@@ -0,0 +1,23 @@
+// Shared transport settings for the three stages, loaded from configs/pipeline/config.yml
+#pragma once
+#include <string>
+
+inline constexpr const char* kPipelineConfigPath = "configs/pipeline/config.yml";
+
+// How frames are distributed from the generator to the extractors
+enum class TransportMode {
+    PubSub,     // every subscriber gets every frame
+    PushPull,   // frames are load-balanced across extractors, results fan back in to the logger
+};
+
+struct TransportConfig {
+    TransportMode mode = TransportMode::PubSub;
+    std::string image_endpoint = "ipc:///tmp/camera_pub.sock";
+    std::string features_endpoint = "ipc:///tmp/features_pub.sock";
+};
+
+const char* transport_mode_name(TransportMode mode);
+
+// Reads the transport section of the pipeline config. Missing keys keep their defaults,
+// a missing file is reported and yields the defaults (the original hard-wired ipc sockets).
+TransportConfig loadTransportConfig(const std::string& path = kPipelineConfigPath);
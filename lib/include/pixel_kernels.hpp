@@ -0,0 +1,53 @@
+// Pixel kernels for every layout OpenCVImageReader can emit (8/16 bit, 1/3/4 channels).
+// Each layout has a scalar, SSE4.2, AVX2 and AVX-512 variant; the fastest one the CPU
+// supports is picked once at startup from CPUID.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+enum class SimdLevel {
+    Scalar = 0,
+    SSE42  = 1,
+    AVX2   = 2,
+    AVX512 = 3,     // F + BW
+};
+
+const char* simd_level_name(SimdLevel level);
+
+// Highest level this CPU supports (always Scalar on non-x86 builds)
+SimdLevel detect_simd_level();
+
+// Level used by pixel_kernels(pixel_format), detected on first use
+SimdLevel active_simd_level();
+
+// Kernels for one pixel layout. Pointers take untyped buffers whose element type is the
+// layout's depth (uint8_t or uint16_t); n always counts pixels, not bytes or samples.
+struct PixelKernels {
+    uint32_t depth_bytes;   // 1 or 2
+    uint32_t channels;      // 1, 3 or 4
+
+    // Interleaved BGR/BGRA -> single channel of the same depth, BT.601 luma weights.
+    // Single channel layouts copy.
+    void (*to_gray)(const void* src, void* dst, size_t n);
+
+    // Interleaved -> planar, dst[c] receives n samples of channel c
+    void (*split)(const void* src, void* const* dst, size_t n);
+
+    // Every sample scaled into [0, 1], writes n * channels floats
+    void (*normalize)(const void* src, float* dst, size_t n);
+
+    // 2x2 box filter, (width / 2) x (height / 2) output rows packed without padding.
+    // src_stride is the distance between source rows in bytes.
+    void (*downscale2x)(const void* src, size_t src_stride, void* dst, size_t width, size_t height);
+
+    // 256-bin histogram of a single channel buffer of this depth (16 bit uses the high byte).
+    // bins is overwritten, not accumulated into.
+    void (*histogram)(const void* src, size_t n, uint32_t* bins);
+};
+
+// Kernels for an OpenCV type code as carried in ImageHeader::pixel_format
+// (CV_8UC1/3/4, CV_16UC1/3/4). Returns nullptr for layouts without kernels.
+const PixelKernels* pixel_kernels(uint32_t pixel_format);
+
+// Same, for an explicit level. Levels above detect_simd_level() must not be called.
+const PixelKernels* pixel_kernels(uint32_t pixel_format, SimdLevel level);
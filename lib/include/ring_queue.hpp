@@ -0,0 +1,352 @@
+// Bounded lock-free ring buffers for handing frames between a stage's threads.
+//
+//   SpscRing<T>     one producer, one consumer: two indices, no read-modify-write on the hot path
+//   MpmcRing<T>     any number of producers and consumers (Vyukov's bounded queue: a sequence
+//                   number per slot, one CAS per item or per batch)
+//   RingQueue<Ring> blocking push/pop/popBatch/close on top of either, same interface as
+//                   WorkQueue. Sleeps on futexes that ShutdownHandler wakes on shutdown.
+//
+// Capacity is rounded up to a power of two. Slots hold default-constructed T and items are
+// moved in and out, so T should be cheap to default-construct and move (frame handles,
+// zmq messages, vectors). Indices written by different threads sit on separate cache lines.
+#pragma once
+#include "cpu_relax.hpp"
+#include "shutdown_handler.hpp"
+#include "wait_word.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+inline constexpr size_t kCacheLineSize = 64;
+
+inline size_t ring_capacity(size_t requested) {
+    size_t capacity = 2;
+    while (capacity < requested) capacity <<= 1;
+    return capacity;
+}
+
+// -----------------------------------------------------------
+//  Single producer, single consumer
+// -----------------------------------------------------------
+
+template <typename T>
+class SpscRing {
+public:
+    using value_type = T;
+
+    explicit SpscRing(size_t capacity)
+        : mask(ring_capacity(capacity) - 1), slots(new T[mask + 1]) {}
+
+    size_t capacity() const { return mask + 1; }
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // Producer only. item is moved from only when it was queued.
+    bool tryPush(T&& item) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_cached == capacity()) {
+            head_cached = head.load(std::memory_order_acquire);
+            if (t - head_cached == capacity()) return false;
+        }
+        slots[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Moves as many of items[0, count) as fit, publishing them at once.
+    size_t tryPushBatch(T* items, size_t count) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (capacity() - (t - head_cached) < count)
+            head_cached = head.load(std::memory_order_acquire);
+
+        const size_t n = std::min(count, capacity() - (t - head_cached));
+        for (size_t i = 0; i < n; ++i) slots[(t + i) & mask] = std::move(items[i]);
+        if (n) tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer only
+    bool tryPop(T& out) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_cached) {
+            tail_cached = tail.load(std::memory_order_acquire);
+            if (h == tail_cached) return false;
+        }
+        out = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Appends up to max items to out, releasing their slots at once.
+    size_t tryPopBatch(std::vector<T>& out, size_t max) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (tail_cached - h < max)
+            tail_cached = tail.load(std::memory_order_acquire);
+
+        const size_t n = std::min(max, tail_cached - h);
+        for (size_t i = 0; i < n; ++i) out.push_back(std::move(slots[(h + i) & mask]));
+        if (n) head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    const size_t mask;
+    const std::unique_ptr<T[]> slots;
+
+    // producer's line: its index and its last view of the consumer's
+    alignas(kCacheLineSize) std::atomic<size_t> tail{0};
+    size_t head_cached = 0;
+
+    // consumer's line
+    alignas(kCacheLineSize) std::atomic<size_t> head{0};
+    size_t tail_cached = 0;
+};
+
+// -----------------------------------------------------------
+//  Multiple producers, multiple consumers
+// -----------------------------------------------------------
+
+template <typename T>
+class MpmcRing {
+public:
+    using value_type = T;
+
+    explicit MpmcRing(size_t capacity)
+        : mask(ring_capacity(capacity) - 1), cells(new Cell[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask + 1; }
+    size_t size() const {
+        const size_t enq = enqueue_pos.load(std::memory_order_acquire);
+        const size_t deq = dequeue_pos.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    // item is moved from only when it was queued
+    bool tryPush(T&& item) {
+        return tryPushBatch(&item, 1) == 1;
+    }
+
+    // Claims a run of free slots with one CAS and moves items[0, n) into them
+    size_t tryPushBatch(T* items, size_t count) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        size_t n = 0;
+        for (;;) {
+            // a slot is free for position p once its sequence reads p; it stays free until
+            // whoever claims p fills it, so the run checked here is still free after the CAS
+            n = 0;
+            while (n < count) {
+                const size_t seq = cells[(pos + n) & mask].sequence.load(std::memory_order_acquire);
+                if (seq != pos + n) break;
+                ++n;
+            }
+            if (n == 0) {
+                const size_t seq = cells[pos & mask].sequence.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq - pos) < 0) return 0;   // full
+                pos = enqueue_pos.load(std::memory_order_relaxed);  // another producer moved on
+                continue;
+            }
+            if (enqueue_pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                break;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            Cell& cell = cells[(pos + i) & mask];
+            cell.value = std::move(items[i]);
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    bool tryPop(T& out) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // empty
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Claims a run of filled slots with one CAS and appends up to max items to out
+    size_t tryPopBatch(std::vector<T>& out, size_t max) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        size_t n = 0;
+        for (;;) {
+            n = 0;
+            while (n < max) {
+                const size_t seq = cells[(pos + n) & mask].sequence.load(std::memory_order_acquire);
+                if (seq != pos + n + 1) break;
+                ++n;
+            }
+            if (n == 0) {
+                const size_t seq = cells[pos & mask].sequence.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq - (pos + 1)) < 0) return 0;   // empty
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (dequeue_pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                break;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            Cell& cell = cells[(pos + i) & mask];
+            out.push_back(std::move(cell.value));
+            cell.sequence.store(pos + i + mask + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+private:
+    // one slot per line, so neighbouring producers and consumers do not share one
+    struct alignas(kCacheLineSize) Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    const size_t mask;
+    const std::unique_ptr<Cell[]> cells;
+
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_pos{0};
+    alignas(kCacheLineSize) std::atomic<size_t> dequeue_pos{0};};
+
+// -----------------------------------------------------------
+//  Blocking wrapper
+// -----------------------------------------------------------
+
+// Spins briefly, then sleeps on a futex. The other side only pays for a syscall when
+// someone is actually asleep. Besides close(), shutdown ends every wait: pop keeps returning
+// queued items and returns false once empty, push gives up.
+template <typename Ring>
+class RingQueue {
+public:
+    using T = typename Ring::value_type;
+
+    explicit RingQueue(size_t capacity) : ring(capacity) {
+        ShutdownHandler::registerWakeup(&not_empty);
+        ShutdownHandler::registerWakeup(&not_full);
+    }
+
+    ~RingQueue() {
+        ShutdownHandler::unregisterWakeup(&not_empty);
+        ShutdownHandler::unregisterWakeup(&not_full);
+    }
+
+    RingQueue(const RingQueue&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    // Blocks while the queue is full. Returns false if the queue was closed.
+    bool push(T item) {
+        const bool pushed = retry(not_full,
+            [&] { return !isClosed() && ring.tryPush(std::move(item)); },
+            [&] { return isClosed() || !ShutdownHandler::running(); });
+        if (pushed) not_empty.notify();
+        return pushed;
+    }
+
+    // Blocks until every item is queued, publishing them in as few runs as possible.
+    // Returns how many were moved from items, fewer only on close or shutdown.
+    size_t pushBatch(T* items, size_t count) {
+        size_t pushed = 0;
+        retry(not_full,
+            [&] {
+                if (isClosed()) return false;
+                if (const size_t n = ring.tryPushBatch(items + pushed, count - pushed)) {
+                    pushed += n;
+                    not_empty.notify();
+                }
+                return pushed == count;
+            },
+            [&] { return isClosed() || !ShutdownHandler::running(); });
+        return pushed;
+    }
+
+    // Blocks while the queue is empty. Returns false once closed and drained.
+    bool pop(T& out) {
+        const bool popped = retry(not_empty,
+            [&] { return ring.tryPop(out); },
+            [&] { return isClosed() || !ShutdownHandler::running(); });
+        if (popped) not_full.notify();
+        return popped;
+    }
+
+    // Blocks while the queue is empty, then moves up to max items into out (appended).
+    // Returns the number taken, 0 once closed and drained.
+    size_t popBatch(std::vector<T>& out, size_t max) {
+        size_t taken = 0;
+        retry(not_empty,
+            [&] { return (taken = ring.tryPopBatch(out, max)) != 0; },
+            [&] { return isClosed() || !ShutdownHandler::running(); });
+        if (taken) not_full.notify();
+        return taken;
+    }
+
+    // Wakes every waiter; pending items can still be popped
+    void close() {
+        closed.store(true, std::memory_order_release);
+        not_empty.wakeAll();
+        not_full.wakeAll();
+    }
+
+    size_t size() const { return ring.size(); }
+    size_t capacity() const { return ring.capacity(); }
+
+private:
+    // a handoff usually completes within a few hundred nanoseconds, well under a futex round
+    // trip; on a single core the other side cannot run while we spin, so go straight to sleep
+    static constexpr int kSpins = 128;
+    // safety net for waiters ShutdownHandler had no wakeup slot for
+    static constexpr uint32_t kWaitTimeoutUs = 100000;
+
+    Ring ring;
+    std::atomic<bool> closed{false};
+    WaitWord not_empty;
+    WaitWord not_full;
+
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    // Calls attempt until it succeeds or stop says to give up; spins first, then sleeps on
+    // word. A waiter only announces itself once a plain attempt has failed.
+    template <typename Attempt, typename Stop>
+    static bool retry(WaitWord& word, Attempt attempt, Stop stop) {
+        static const int spins = std::thread::hardware_concurrency() > 1 ? kSpins : 0;
+        for (int spin = 0;; ++spin) {
+            if (attempt()) return true;
+            if (stop()) return false;
+            if (spin < spins) {
+                cpu_relax();
+                continue;
+            }
+
+            const uint32_t seen = word.prepare();
+            if (attempt()) {
+                word.cancel();
+                return true;
+            }
+            if (stop()) {
+                word.cancel();
+                return false;
+            }
+            word.wait(seen, kWaitTimeoutUs);
+        }
+    }
+};
+
+template <typename T> using SpscQueue = RingQueue<SpscRing<T>>;
+template <typename T> using MpmcQueue = RingQueue<MpmcRing<T>>;
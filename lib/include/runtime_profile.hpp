@@ -0,0 +1,36 @@
+// Per-stage thread placement, read from the runtime section of configs/pipeline/config.yml.
+// A stage applies its profile on its main thread before starting any other thread, so its
+// workers, sender and writer threads inherit the CPU set and memory policy. SCHED_FIFO is
+// only given to the stage's receive (or publish) thread, once the others have started.
+// Every setting is optional; the defaults leave placement to the OS.
+#pragma once
+#include "pipeline_config.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct RuntimeProfile {
+    std::vector<int> cpus;          // threads of the stage run only on these, empty = anywhere
+    bool numa_local = false;        // allocate (frame buffers included) on the NUMA node of cpus
+    bool busy_poll = false;         // spin on ZMQ_DONTWAIT instead of sleeping in recv/send
+    int realtime_priority = 0;      // 1-99 requests SCHED_FIFO at that priority, for one thread
+};
+
+// "0-3,6" -> {0, 1, 2, 3, 6}. Malformed entries are reported and skipped.
+std::vector<int> parse_cpu_list(const std::string& text);
+std::string format_cpu_list(const std::vector<int>& cpus);
+
+// Reads runtime.<stage>; a missing file or section yields the default (unconstrained) profile
+RuntimeProfile loadRuntimeProfile(const std::string& stage, const std::string& path = kPipelineConfigPath);
+
+// Applies the CPU set and memory policy to the calling thread and reports the placement it
+// actually got, which can differ from the request (CPUs offline, ...)
+void applyRuntimeProfile(const std::string& stage, const RuntimeProfile& profile);
+
+// Moves the calling thread, and only it, to SCHED_FIFO at realtime_priority. Call it after
+// the stage's other threads are started so they keep time-slicing. Refused when the thread
+// busy-polls with a single CPU to run on, where it would never let the others in.
+void applyRealtimePriority(const std::string& thread, const RuntimeProfile& profile);
+
+// CPUs the calling thread may run on (its affinity mask), at least 1
+size_t usable_cpu_count();
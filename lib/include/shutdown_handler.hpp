@@ -1,13 +1,39 @@
 #pragma once
 #include <atomic>
 #include <csignal>
+#include <cstddef>
+#include <cstdint>
+
+class WaitWord;
 
 class ShutdownHandler {
 public:
     static void init();
     static bool running();
 
+    // Stops every loop polling running(), e.g. when one stage of the single-process
+    // pipeline fails and the others should not keep going without it
+    static void requestShutdown();
+
+    // Words woken when shutdown starts, so threads sleeping on them notice at once.
+    // Returns false if every slot is taken; such waiters only notice on their own timeout.
+    static bool registerWakeup(WaitWord* word);
+    static void unregisterWakeup(WaitWord* word);
+
+    // SIGUSR1 does not stop anything: it counts a trace dump request and wakes the word
+    // the trace exporter sleeps on (see trace.hpp). It is blocked in every thread and
+    // taken by a sigwait thread, so it never interrupts a blocking recv.
+    static uint64_t traceDumpRequests();
+    static void setTraceDumpWakeup(WaitWord* word);
+
 private:
+    static constexpr size_t kMaxWakeups = 64;
+
     static void handle_signal(int sig);
+    static void requestTraceDump();
+    static void wakeRegistered();
     static std::atomic<bool> keep_running;
+    static std::atomic<WaitWord*> wakeups[kMaxWakeups];
+    static std::atomic<uint64_t> trace_dump_requests;
+    static std::atomic<WaitWord*> trace_dump_wakeup;
 };
\ No newline at end of file
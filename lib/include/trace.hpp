@@ -0,0 +1,76 @@
+// Per-frame trace spans. Every thread records into its own fixed-size ring, so recording
+// is a clock read and a few relaxed stores on a line no other thread writes, with no locks
+// and no allocation after the thread's first span. The newest events_per_thread spans of
+// every thread are kept; kill -USR1 <pid> writes them as a Chrome trace (open it in
+// chrome://tracing or ui.perfetto.dev).
+//
+//   TraceSession tracing("feature_extractor");      // once per stage, starts the exporter
+//   trace_thread_name("feature_extractor/worker");  // once per thread, optional
+//   { TraceSpan span("decode", frame_number); ... } // recorded when the scope ends
+#pragma once
+#include "pipeline_config.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+struct TraceConfig {
+    bool enabled = true;
+    size_t events_per_thread = 16384;   // ~640 KB per thread
+    std::string output_dir = "/tmp";
+    bool dump_on_exit = false;
+};
+
+// Reads the trace section of the pipeline config; a missing file or section keeps the defaults
+TraceConfig loadTraceConfig(const std::string& path = kPipelineConfigPath);
+
+inline uint64_t trace_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool trace_enabled();
+
+// Records one finished span on the calling thread's ring. frames > 1 marks a span that
+// covered a batch starting at frame.
+void trace_record(const char* name, uint64_t frame, uint64_t start_ns, uint64_t end_ns,
+                  uint32_t frames = 1);
+
+// Shown as the thread's name in the trace viewer
+void trace_thread_name(const std::string& name);
+
+// Writes every thread's ring to <output_dir>/trace_<process>_<pid>_<n>.json and returns the
+// path, empty on failure
+std::string trace_dump();
+
+// Scoped span; name must outlive the process (a string literal)
+class TraceSpan {
+public:
+    TraceSpan(const char* name, uint64_t frame, uint32_t frames = 1)
+        : name(trace_enabled() ? name : nullptr), frame(frame), frames(frames),
+          start_ns(this->name ? trace_now_ns() : 0) {}
+
+    ~TraceSpan() {
+        if (name) trace_record(name, frame, start_ns, trace_now_ns(), frames);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    uint64_t frame;
+    uint32_t frames;
+    uint64_t start_ns;
+};
+
+// Loads the config and, for the first session of the process, starts the thread that
+// writes a dump on every SIGUSR1. Sessions nest: the single-process pipeline opens one per
+// stage and the exporter stops with the last.
+class TraceSession {
+public:
+    explicit TraceSession(const std::string& process_name);
+    ~TraceSession();
+
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+};
@@ -0,0 +1,102 @@
+// Socket factories for the configured transport. Each stage asks for its role and gets a
+// socket of the right type, already bound or connected to the right endpoint.
+//
+//                 pubsub                     pushpull
+//  generator      PUB  bind    image         PUSH bind    image
+//  extractor in   SUB  connect image         PULL connect image
+//  extractor out  PUB  bind    features      PUSH connect features
+//  logger         SUB  connect features      PULL bind    features
+#pragma once
+#include "cpu_relax.hpp"
+#include "pipeline_config.hpp"
+#include <chrono>
+#include <vector>
+#include <zmq.hpp>
+
+inline zmq::socket_t makeImageSender(zmq::context_t& ctx, const TransportConfig& cfg) {
+    const bool push = cfg.mode == TransportMode::PushPull;
+    zmq::socket_t socket(ctx, push ? zmq::socket_type::push : zmq::socket_type::pub);
+    socket.bind(cfg.image_endpoint);
+    return socket;
+}
+
+inline zmq::socket_t makeImageReceiver(zmq::context_t& ctx, const TransportConfig& cfg) {
+    const bool pull = cfg.mode == TransportMode::PushPull;
+    zmq::socket_t socket(ctx, pull ? zmq::socket_type::pull : zmq::socket_type::sub);
+    socket.connect(cfg.image_endpoint);
+    if (!pull) socket.set(zmq::sockopt::subscribe, ""); // empty filter = all topics
+    return socket;
+}
+
+inline zmq::socket_t makeFeatureSender(zmq::context_t& ctx, const TransportConfig& cfg) {
+    if (cfg.mode == TransportMode::PushPull) {
+        zmq::socket_t socket(ctx, zmq::socket_type::push);
+        socket.connect(cfg.features_endpoint);
+        return socket;
+    }
+    zmq::socket_t socket(ctx, zmq::socket_type::pub);
+    socket.bind(cfg.features_endpoint);
+    return socket;
+}
+
+inline zmq::socket_t makeFeatureReceiver(zmq::context_t& ctx, const TransportConfig& cfg) {
+    if (cfg.mode == TransportMode::PushPull) {
+        zmq::socket_t socket(ctx, zmq::socket_type::pull);
+        socket.bind(cfg.features_endpoint);
+        return socket;
+    }
+    zmq::socket_t socket(ctx, zmq::socket_type::sub);
+    socket.connect(cfg.features_endpoint);
+    socket.set(zmq::sockopt::subscribe, ""); // empty filter = all topics
+    return socket;
+}
+
+// -----------------------------------------------------------
+//  Runtime profile support
+// -----------------------------------------------------------
+
+// Keeps zmq's own I/O threads on the stage's CPUs. Only takes effect before the context's
+// first socket exists; inproc-only contexts have no I/O threads to place.
+inline void pinIoThreads(zmq::context_t& ctx, const std::vector<int>& cpus) {
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+    for (int cpu : cpus) zmq_ctx_set(ctx.handle(), ZMQ_THREAD_AFFINITY_CPU_ADD, cpu);
+#else
+    (void)ctx;
+    (void)cpus;
+#endif
+}
+
+// Busy-polling gives up after this long, like a 100 ms rcvtimeo/sndtimeo would, so callers
+// still get to check for shutdown
+inline constexpr auto kBusyPollSlice = std::chrono::milliseconds(100);
+
+// Receives the first part of the next message. Blocking waits up to the socket's rcvtimeo;
+// busy-polling spins on ZMQ_DONTWAIT, picking a frame up without a kernel wakeup at the
+// cost of a core. Returns an empty result when nothing arrived.
+inline zmq::recv_result_t recvFirstPart(zmq::socket_t& socket, zmq::message_t& msg, bool busy_poll) {
+    if (!busy_poll) return socket.recv(msg, zmq::recv_flags::none);
+
+    const auto deadline = std::chrono::steady_clock::now() + kBusyPollSlice;
+    for (unsigned spin = 0;; ++spin) {
+        if (zmq::recv_result_t received = socket.recv(msg, zmq::recv_flags::dontwait))
+            return received;
+        if ((spin & 1023) == 0 && std::chrono::steady_clock::now() >= deadline)
+            return {};
+        cpu_relax();
+    }
+}
+
+// Sends the first part of a multipart message, the same way. Once it is queued the
+// remaining parts always are too, so only the first one needs retrying.
+inline bool sendFirstPart(zmq::socket_t& socket, zmq::const_buffer part, bool busy_poll) {
+    if (!busy_poll) return socket.send(part, zmq::send_flags::sndmore).has_value();
+
+    const auto deadline = std::chrono::steady_clock::now() + kBusyPollSlice;
+    for (unsigned spin = 0;; ++spin) {
+        if (socket.send(part, zmq::send_flags::sndmore | zmq::send_flags::dontwait))
+            return true;
+        if ((spin & 1023) == 0 && std::chrono::steady_clock::now() >= deadline)
+            return false;
+        cpu_relax();
+    }
+}
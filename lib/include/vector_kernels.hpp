@@ -0,0 +1,28 @@
+// Squared L2 distance kernels for the feature index (feature_index.hpp). Like the pixel
+// kernels there is a scalar, SSE4.2, AVX2 and AVX-512 variant, picked from CPUID.
+// Vectors are stored zero-padded to a multiple of kVectorAlign floats, so no variant needs
+// a tail loop and padding never changes a distance.
+#pragma once
+#include "pixel_kernels.hpp"
+#include <cstddef>
+
+inline constexpr size_t kVectorAlign = 8;
+
+inline size_t padded_dims(size_t dims) {
+    return (dims + kVectorAlign - 1) / kVectorAlign * kVectorAlign;
+}
+
+struct VectorKernels {
+    // sum((a[i] - b[i])^2), n a multiple of kVectorAlign
+    float (*l2_squared)(const float* a, const float* b, size_t n);
+
+    // out[j] = l2_squared(query, base + j * stride, stride) for count vectors stored back to back
+    void (*l2_squared_many)(const float* query, const float* base, size_t count, size_t stride,
+                            float* out);
+};
+
+// Kernels for active_simd_level()
+const VectorKernels& vector_kernels();
+
+// Same, for an explicit level. Levels above detect_simd_level() must not be called.
+const VectorKernels& vector_kernels(SimdLevel level);
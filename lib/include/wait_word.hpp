@@ -0,0 +1,48 @@
+// A 32-bit word threads can sleep on until another thread bumps it. On Linux this is a
+// futex, and wakeAll is async-signal-safe, so ShutdownHandler can wake sleepers straight
+// from its signal handler. Other platforms nap in short slices instead, which delays a
+// wakeup by at most kFallbackNapUs.
+//
+//   waiter:  seen = word.prepare();
+//            if (condition holds) word.cancel(); else word.wait(seen, timeout);
+//   waker:   make the condition hold; word.notify();
+//
+// The waiter announces itself before its last check and the waker looks for waiters after
+// making the condition true, so one of them always sees the other. notify() costs a fence
+// and a load when nobody sleeps. A wake takes every announced waiter off the count, so a
+// producer outrunning a consumer that has not been scheduled yet pays for one syscall, not
+// one per item; the count may overestimate (after a cancel or timeout), which only costs
+// one spare wake.
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+class WaitWord {
+public:
+    static constexpr uint32_t kFallbackNapUs = 200;
+
+    uint32_t prepare() {
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        return value.load(std::memory_order_seq_cst);
+    }
+
+    // The condition turned out to hold after prepare(). Leaves the count alone: a waker may
+    // already have cleared it, and taking one off could hide another waiter.
+    void cancel() {}
+
+    // Sleeps while the word still equals seen, for at most timeout_us (0 = no limit).
+    // May return early; callers re-check in a loop.
+    void wait(uint32_t seen, uint32_t timeout_us = 0);
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) != 0) wakeAll();
+    }
+
+    // Wakes every announced waiter, unconditionally
+    void wakeAll();
+
+private:
+    std::atomic<uint32_t> value{0};
+    std::atomic<uint32_t> sleepers{0};
+};
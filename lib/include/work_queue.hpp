@@ -0,0 +1,74 @@
+// Bounded, blocking multi-producer/multi-consumer queue used to hand frames between a
+// stage's receive loop, its worker threads and its sender
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+template <typename T>
+class WorkQueue {
+public:
+    explicit WorkQueue(size_t capacity) : capacity(capacity) {}
+
+    // Blocks while the queue is full. Returns false if the queue was closed.
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mtx);
+        not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+        if (closed) return false;
+
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is empty. Returns false once closed and drained.
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(mtx);
+        not_empty.wait(lock, [&] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+
+        out = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is empty, then moves up to max items into out (appended).
+    // Returns the number taken, 0 once closed and drained.
+    size_t popBatch(std::vector<T>& out, size_t max) {
+        std::unique_lock<std::mutex> lock(mtx);
+        not_empty.wait(lock, [&] { return closed || !items.empty(); });
+
+        size_t taken = 0;
+        while (taken < max && !items.empty()) {
+            out.push_back(std::move(items.front()));
+            items.pop_front();
+            ++taken;
+        }
+        if (taken) not_full.notify_all();
+        return taken;
+    }
+
+    // Wakes every waiter; pending items can still be popped
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return items.size();
+    }
+
+private:
+    const size_t capacity;
+    mutable std::mutex mtx;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<T> items;
+    bool closed = false;
+};
@@ -0,0 +1,397 @@
+#include "feature_index.hpp"
+#include "vector_kernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+
+namespace {
+
+// a list is only worth its centroid once it holds a handful of vectors
+constexpr size_t kMinPerList = 8;
+// k-means runs on a sample, enough to place the centroids without touching every vector
+constexpr size_t kSamplePerList = 32;
+constexpr int kKmeansIterations = 10;
+
+constexpr uint32_t kNoList = std::numeric_limits<uint32_t>::max();
+
+struct Entry {
+    uint64_t image_hash;
+    uint64_t last_frame;
+    uint32_t frames;        // 0 marks a free id
+    int64_t last_logged;
+};
+
+struct List {
+    std::vector<float> vectors;     // stride floats per entry, zero padded
+    std::vector<uint32_t> ids;      // entry of each vector
+};
+
+struct Location {
+    uint32_t list;
+    uint32_t pos;
+};
+
+// Index of the nearest of count vectors, distances written to scratch
+size_t nearest(const float* query, const float* base, size_t count, size_t stride,
+               std::vector<float>& scratch) {
+    scratch.resize(count);
+    vector_kernels().l2_squared_many(query, base, count, stride, scratch.data());
+    return static_cast<size_t>(std::min_element(scratch.begin(), scratch.end()) - scratch.begin());
+}
+
+// Appends entry id's vector to the list whose centroid is nearest, or the only list
+void place(std::vector<List>& lists, std::vector<Location>& locations, const std::vector<float>& centroids,
+           uint32_t id, const float* v, size_t stride, std::vector<float>& scratch) {
+    const size_t c = centroids.empty() ? 0 : nearest(v, centroids.data(), lists.size(), stride, scratch);
+    List& target = lists[c];
+    locations[id] = {static_cast<uint32_t>(c), static_cast<uint32_t>(target.ids.size())};
+    target.vectors.insert(target.vectors.end(), v, v + stride);
+    target.ids.push_back(id);
+}
+
+// Takes entry id's vector out of its list; the list's last vector moves into the hole
+void unplace(std::vector<List>& lists, std::vector<Location>& locations, uint32_t id, size_t stride) {
+    const Location loc = locations[id];
+    List& list = lists[loc.list];
+    const size_t last = list.ids.size() - 1;
+    if (loc.pos != last) {
+        std::memcpy(&list.vectors[size_t(loc.pos) * stride], &list.vectors[last * stride], stride * sizeof(float));
+        list.ids[loc.pos] = list.ids[last];
+        locations[list.ids[loc.pos]].pos = loc.pos;
+    }
+    list.vectors.resize(last * stride);
+    list.ids.pop_back();
+    locations[id] = {kNoList, 0};
+}
+
+// k-means over a sample of n vectors stored back to back. Empty if stop was raised.
+std::vector<float> cluster(const float* vectors, size_t n, size_t stride, size_t lists,
+                           const std::atomic<bool>& stop) {
+    std::vector<const float*> all(n);
+    for (size_t i = 0; i < n; ++i) all[i] = vectors + i * stride;
+
+    std::mt19937_64 rng(n);
+    std::shuffle(all.begin(), all.end(), rng);
+    const size_t samples = std::min(n, lists * kSamplePerList);
+
+    std::vector<float> centroids(lists * stride);
+    for (size_t c = 0; c < lists; ++c) std::memcpy(&centroids[c * stride], all[c], stride * sizeof(float));
+
+    std::vector<float> sums(lists * stride), scratch;
+    std::vector<size_t> members(lists);
+    for (int iteration = 0; iteration < kKmeansIterations; ++iteration) {
+        if (stop.load(std::memory_order_relaxed)) return {};
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(members.begin(), members.end(), 0);
+
+        for (size_t s = 0; s < samples; ++s) {
+            const size_t c = nearest(all[s], centroids.data(), lists, stride, scratch);
+            for (size_t d = 0; d < stride; ++d) sums[c * stride + d] += all[s][d];
+            ++members[c];
+        }
+
+        for (size_t c = 0; c < lists; ++c) {
+            if (members[c] == 0) {
+                // an empty cluster restarts from a random sample
+                std::memcpy(&centroids[c * stride], all[rng() % samples], stride * sizeof(float));
+                continue;
+            }
+            for (size_t d = 0; d < stride; ++d)
+                centroids[c * stride + d] = sums[c * stride + d] / static_cast<float>(members[c]);
+        }
+    }
+    return centroids;
+}
+
+} // namespace
+
+// An entry keeps its id until it is removed, so retraining only rebuilds the lists and
+// locations and frame counts updated meanwhile are never lost
+struct FeatureIndex::Space {
+    explicit Space(size_t dims) : dims(dims), stride(padded_dims(dims)), lists(1) {}
+
+    const size_t dims;
+    const size_t stride;
+    std::vector<float> centroids;   // lists.size() * stride, empty until trained
+    std::vector<List> lists;        // a single list until trained
+    std::vector<Entry> entries;     // by id
+    std::vector<Location> locations;                // by id
+    std::unordered_map<uint64_t, uint32_t> ids;     // image hash -> id
+    std::vector<uint32_t> free_ids;
+    // removed while this space is being clustered; the snapshot may still hold them, so they
+    // are taken out of the new lists at the swap and only reused after it
+    std::vector<uint32_t> freed_while_training;
+    size_t trained_at = 0;          // images at the last training, 0 = never trained
+
+    const float* vectorOf(uint32_t id) const {
+        const Location& loc = locations[id];
+        return lists[loc.list].vectors.data() + size_t(loc.pos) * stride;
+    }
+};
+
+FeatureIndex::FeatureIndex(size_t lists, size_t probes)
+    : max_lists(std::max<size_t>(1, lists)), default_probes(std::max<size_t>(1, probes)) {}
+
+FeatureIndex::~FeatureIndex() {
+    stopping = true;
+    if (trainer.joinable()) trainer.join();
+}
+
+size_t FeatureIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return count;
+}
+
+FeatureIndex::Space& FeatureIndex::spaceFor(size_t dims) {
+    auto& space = spaces[dims];
+    if (!space) space = std::make_unique<Space>(dims);
+    return *space;
+}
+
+// a flat scan is cheap until every list can be given a handful of vectors
+bool FeatureIndex::trainingDue(const Space& space) const {
+    const size_t n = space.ids.size();
+    return space.trained_at == 0 ? n >= max_lists * kMinPerList
+                                 : n >= space.trained_at * kRetrainGrowth;
+}
+
+void FeatureIndex::add(uint64_t image_hash, uint64_t frame_number, const float* features, size_t dims,
+                       int64_t logged_s) {
+    if (dims == 0) return;
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    Space& space = spaceFor(dims);
+
+    auto it = space.ids.find(image_hash);
+    if (it != space.ids.end()) {
+        Entry& entry = space.entries[it->second];
+        entry.last_frame = std::max(entry.last_frame, frame_number);
+        entry.last_logged = std::max(entry.last_logged, logged_s);
+        ++entry.frames;
+        return;
+    }
+
+    thread_local std::vector<float> padded, scratch;
+    padded.assign(space.stride, 0.0f);
+    std::memcpy(padded.data(), features, dims * sizeof(float));
+
+    // while clustering, ids past the snapshot are the ones added since, so none are reused
+    uint32_t id;
+    if (!space.free_ids.empty() && training != &space) {
+        id = space.free_ids.back();
+        space.free_ids.pop_back();
+        space.entries[id] = {image_hash, frame_number, 1, logged_s};
+    } else {
+        id = static_cast<uint32_t>(space.entries.size());
+        space.entries.push_back({image_hash, frame_number, 1, logged_s});
+        space.locations.push_back({kNoList, 0});
+    }
+    space.ids.emplace(image_hash, id);
+    place(space.lists, space.locations, space.centroids, id, padded.data(), space.stride, scratch);
+    ++count;
+
+    if (!training && !stopping && trainingDue(space)) {
+        // a previous run clears training under this lock as its last step, so this join is short
+        if (trainer.joinable()) trainer.join();
+        training = &space;
+        trainer = std::thread(&FeatureIndex::trainLoop, this, &space);
+    }
+}
+
+void FeatureIndex::erase(Space& space, uint32_t id) {
+    unplace(space.lists, space.locations, id, space.stride);
+    space.ids.erase(space.entries[id].image_hash);
+    space.entries[id] = Entry{};
+    (training == &space ? space.freed_while_training : space.free_ids).push_back(id);
+    --count;
+}
+
+bool FeatureIndex::remove(uint64_t image_hash) {
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    for (auto& [dims, space] : spaces) {
+        const auto it = space->ids.find(image_hash);
+        if (it == space->ids.end()) continue;
+        erase(*space, it->second);
+        return true;
+    }
+    return false;
+}
+
+size_t FeatureIndex::removeLoggedBefore(int64_t unix_s) {
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    size_t removed = 0;
+    for (auto& [dims, space] : spaces) {
+        for (size_t id = 0; id < space->entries.size(); ++id) {
+            const Entry& entry = space->entries[id];
+            if (entry.frames == 0 || entry.last_logged >= unix_s) continue;
+            erase(*space, static_cast<uint32_t>(id));
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+void FeatureIndex::waitForTraining() {
+    std::thread running;
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        running = std::move(trainer);
+    }
+    if (running.joinable()) running.join();
+}
+
+// Clusters a copy of the space without holding the lock, then swaps the new lists in. Vectors
+// added after the copy are placed by the new centroids during the swap, removed ones taken
+// out. Repeats while the space grew past the next threshold in the meantime.
+void FeatureIndex::trainLoop(Space* space) {
+    const size_t stride = space->stride;
+    std::vector<float> vectors, scratch;
+    std::vector<uint32_t> ids;
+
+    while (true) {
+        const auto started = std::chrono::steady_clock::now();
+        size_t snapshot_entries = 0;
+        {
+            // adds wait for the copy only, searches not at all
+            std::shared_lock<std::shared_mutex> lock(mtx);
+            vectors.clear();
+            ids.clear();
+            for (const List& list : space->lists) {
+                vectors.insert(vectors.end(), list.vectors.begin(), list.vectors.end());
+                ids.insert(ids.end(), list.ids.begin(), list.ids.end());
+            }
+            snapshot_entries = space->entries.size();
+        }
+
+        const size_t n = ids.size();
+        const size_t list_count = std::max<size_t>(1, std::min(max_lists, n / kMinPerList));
+        if (n < list_count * kMinPerList) {
+            // retention emptied the space after training became due; the next add that
+            // makes it due again starts a new run
+            std::unique_lock<std::shared_mutex> lock(mtx);
+            space->free_ids.insert(space->free_ids.end(), space->freed_while_training.begin(),
+                                   space->freed_while_training.end());
+            space->freed_while_training.clear();
+            training = nullptr;
+            return;
+        }
+        std::vector<float> centroids = cluster(vectors.data(), n, stride, list_count, stopping);
+        if (centroids.empty()) return;  // shutting down
+
+        std::vector<List> rebuilt(list_count);
+        std::vector<Location> locations(snapshot_entries, Location{kNoList, 0});
+        for (size_t i = 0; i < n; ++i)
+            place(rebuilt, locations, centroids, ids[i], vectors.data() + i * stride, stride, scratch);
+
+        size_t added = 0;
+        bool again = false;
+        {
+            std::unique_lock<std::shared_mutex> lock(mtx);
+            for (uint32_t id : space->freed_while_training) {
+                if (id < locations.size() && locations[id].list != kNoList)
+                    unplace(rebuilt, locations, id, stride);
+            }
+            space->free_ids.insert(space->free_ids.end(), space->freed_while_training.begin(),
+                                   space->freed_while_training.end());
+            space->freed_while_training.clear();
+
+            locations.resize(space->entries.size(), Location{kNoList, 0});
+            for (size_t id = snapshot_entries; id < space->entries.size(); ++id) {
+                if (space->entries[id].frames == 0) continue;
+                place(rebuilt, locations, centroids, static_cast<uint32_t>(id), space->vectorOf(id), stride, scratch);
+                ++added;
+            }
+
+            space->centroids = std::move(centroids);
+            space->lists = std::move(rebuilt);
+            space->locations = std::move(locations);
+            space->trained_at = n;
+
+            again = !stopping && trainingDue(*space);
+            if (!again) training = nullptr;
+        }
+
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        std::cout << "[Index] Clustered " << n << " vectors of " << space->dims << " features into "
+                  << list_count << " lists in " << ms << " ms (" << added << " added meanwhile)" << std::endl;
+        if (!again) return;
+    }
+}
+
+std::vector<IndexMatch> FeatureIndex::search(const float* query, size_t dims, size_t k,
+                                             size_t probes) const {
+    std::vector<IndexMatch> matches;
+    if (k == 0 || dims == 0) return matches;
+
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    const auto found = spaces.find(dims);
+    if (found == spaces.end()) return matches;
+    const Space& space = *found->second;
+    const VectorKernels& kernels = vector_kernels();
+
+    thread_local std::vector<float> padded, distances;
+    thread_local std::vector<uint32_t> order;
+    padded.assign(space.stride, 0.0f);
+    std::memcpy(padded.data(), query, dims * sizeof(float));
+
+    // the lists whose centroids are nearest the query
+    order.resize(space.lists.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<uint32_t>(i);
+    size_t scan = order.size();
+    if (!space.centroids.empty()) {
+        scan = std::min(scan, probes ? probes : default_probes);
+        distances.resize(space.lists.size());
+        kernels.l2_squared_many(padded.data(), space.centroids.data(), space.lists.size(), space.stride,
+                                distances.data());
+        std::partial_sort(order.begin(), order.begin() + scan, order.end(),
+                          [&](uint32_t a, uint32_t b) { return distances[a] < distances[b]; });
+    }
+
+    // max-heap on distance holding the k best so far
+    using Candidate = std::pair<float, uint32_t>;
+    std::vector<Candidate> best;
+    best.reserve(k + 1);
+    auto farther = [](const Candidate& a, const Candidate& b) { return a.first < b.first; };
+
+    for (size_t p = 0; p < scan; ++p) {
+        const List& list = space.lists[order[p]];
+        const size_t n = list.ids.size();
+        distances.resize(n);
+        kernels.l2_squared_many(padded.data(), list.vectors.data(), n, space.stride, distances.data());
+
+        for (size_t i = 0; i < n; ++i) {
+            if (best.size() == k && distances[i] >= best.front().first) continue;
+            best.emplace_back(distances[i], list.ids[i]);
+            std::push_heap(best.begin(), best.end(), farther);
+            if (best.size() > k) {
+                std::pop_heap(best.begin(), best.end(), farther);
+                best.pop_back();
+            }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end(), farther);
+    matches.reserve(best.size());
+    for (const auto& [distance, id] : best) {
+        const Entry& entry = space.entries[id];
+        matches.push_back({entry.image_hash, entry.last_frame, entry.frames, distance});
+    }
+    return matches;
+}
+
+bool FeatureIndex::vectorOf(uint64_t image_hash, std::vector<float>& out) const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    for (const auto& [dims, space] : spaces) {
+        const auto it = space->ids.find(image_hash);
+        if (it == space->ids.end()) continue;
+        const float* v = space->vectorOf(it->second);
+        out.assign(v, v + dims);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+#include "pipeline_config.hpp"
+#include <yaml-cpp/yaml.h>
+#include <iostream>
+#include <stdexcept>
+
+const char* transport_mode_name(TransportMode mode) {
+    switch (mode) {
+    case TransportMode::PubSub:   return "pubsub";
+    case TransportMode::PushPull: return "pushpull";
+    }
+    return "unknown";
+}
+
+TransportConfig loadTransportConfig(const std::string& path) {
+    TransportConfig cfg;
+
+    YAML::Node root;
+    try {
+        root = YAML::LoadFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Failed to load pipeline config from " << path
+                  << " (" << e.what() << "), using default transport\n";
+        return cfg;
+    }
+
+    const auto& t = root["transport"];
+    if (!t) return cfg;
+
+    if (t["mode"]) {
+        const std::string mode = t["mode"].as<std::string>();
+        if (mode == "pubsub")        cfg.mode = TransportMode::PubSub;
+        else if (mode == "pushpull") cfg.mode = TransportMode::PushPull;
+        else throw std::runtime_error("Unknown transport mode: " + mode);
+    }
+    if (t["image_endpoint"])    cfg.image_endpoint = t["image_endpoint"].as<std::string>();
+    if (t["features_endpoint"]) cfg.features_endpoint = t["features_endpoint"].as<std::string>();
+
+    return cfg;
+}
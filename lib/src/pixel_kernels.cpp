@@ -0,0 +1,68 @@
+// Scalar kernel variant and CPUID dispatch. This file is built without auto-vectorization
+// so the scalar table stays the reference the SIMD variants are checked against.
+#include "pixel_kernels.hpp"
+#include "pixel_kernels_impl.hpp"
+
+// defined by the per instruction set translation units, nullptr when built without the ISA
+const PixelKernels* pixel_kernels_sse42(uint32_t pixel_format);
+const PixelKernels* pixel_kernels_avx2(uint32_t pixel_format);
+const PixelKernels* pixel_kernels_avx512(uint32_t pixel_format);
+
+namespace {
+
+const PixelKernels* pixel_kernels_scalar(uint32_t pixel_format) {
+    static const KernelSet set = make_generic_set();
+    return set.lookup(pixel_format);
+}
+
+} // namespace
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::SSE42:  return "sse4.2";
+    case SimdLevel::AVX2:   return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+SimdLevel detect_simd_level() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return SimdLevel::SSE42;
+#endif
+    return SimdLevel::Scalar;
+}
+
+SimdLevel active_simd_level() {
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+const PixelKernels* pixel_kernels(uint32_t pixel_format) {
+    return pixel_kernels(pixel_format, active_simd_level());
+}
+
+// Falls back one level at a time when a variant was not compiled in (e.g. non-x86 builds)
+const PixelKernels* pixel_kernels(uint32_t pixel_format, SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512:
+        if (const PixelKernels* k = pixel_kernels_avx512(pixel_format)) return k;
+        [[fallthrough]];
+    case SimdLevel::AVX2:
+        if (const PixelKernels* k = pixel_kernels_avx2(pixel_format)) return k;
+        [[fallthrough]];
+    case SimdLevel::SSE42:
+        if (const PixelKernels* k = pixel_kernels_sse42(pixel_format)) return k;
+        [[fallthrough]];
+    case SimdLevel::Scalar:
+        break;
+    }
+    return pixel_kernels_scalar(pixel_format);
+}
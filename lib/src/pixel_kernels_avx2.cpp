@@ -0,0 +1,101 @@
+// AVX2 kernel variant: hand-written luma and normalize, the rest auto-vectorized
+#include "pixel_kernels_impl.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+// 8 BGRA pixels, one per 32-bit lane -> 8 luma values in 32-bit lanes
+inline __m256i luma_bgra(__m256i px) {
+    const __m256i low_bytes = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i w_br = _mm256_set1_epi32(static_cast<int>((kWeightR << 16) | kWeightB));
+    const __m256i w_ga = _mm256_set1_epi32(static_cast<int>(kWeightG));
+
+    const __m256i br = _mm256_and_si256(px, low_bytes);
+    const __m256i ga = _mm256_and_si256(_mm256_srli_epi32(px, 8), low_bytes);
+    const __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(br, w_br), _mm256_madd_epi16(ga, w_ga));
+    return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8);
+}
+
+template <int C>
+void to_gray_u8(const void* src, void* dst, size_t n) {
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    uint8_t* d = static_cast<uint8_t*>(dst);
+
+    // spreads 4 packed BGR pixels into BGR0 lanes, per 128-bit half
+    const __m256i expand = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    // BGR reads two 16 byte halves 12 bytes apart
+    constexpr size_t kReadBytes = C == 3 ? 28 : 32;
+
+    size_t i = 0;
+    for (; i * C + kReadBytes <= n * C; i += 8) {
+        __m256i px;
+        if constexpr (C == 3) {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 3));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 3 + 12));
+            px = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), expand);
+        } else {
+            px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i * 4));
+        }
+
+        // packs stay within 128-bit lanes: each half ends with its 4 bytes at the bottom
+        const __m256i g32 = luma_bgra(px);
+        const __m256i g8 = _mm256_packus_epi16(_mm256_packus_epi32(g32, g32), g32);
+        const int lo4 = _mm_cvtsi128_si32(_mm256_castsi256_si128(g8));
+        const int hi4 = _mm_cvtsi128_si32(_mm256_extracti128_si256(g8, 1));
+        std::memcpy(d + i, &lo4, 4);
+        std::memcpy(d + i + 4, &hi4, 4);
+    }
+    GenericKernels<uint8_t, C>::to_gray(s + i * C, d + i, n - i);
+}
+
+template <typename T, int C>
+void normalize(const void* src, float* dst, size_t n) {
+    const T* s = static_cast<const T*>(src);
+    const size_t samples = n * C;
+    const __m256 scale = _mm256_set1_ps(DepthTraits<T>::kInvMax);
+
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m256i wide;
+        if constexpr (sizeof(T) == 1)
+            wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i)));
+        else
+            wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(wide), scale));
+    }
+    for (; i < samples; ++i)
+        dst[i] = static_cast<float>(s[i]) * DepthTraits<T>::kInvMax;
+}
+
+template <typename T, int C>
+void install(PixelKernels& k) {
+    if constexpr (sizeof(T) == 1 && C != 1) k.to_gray = &to_gray_u8<C>;
+    k.normalize = &normalize<T, C>;
+}
+
+KernelSet make_avx2_set() {
+    KernelSet set = make_generic_set();
+    install<uint8_t, 1>(set.u8[1]);
+    install<uint8_t, 3>(set.u8[3]);
+    install<uint8_t, 4>(set.u8[4]);
+    install<uint16_t, 1>(set.u16[1]);
+    install<uint16_t, 3>(set.u16[3]);
+    install<uint16_t, 4>(set.u16[4]);
+    return set;
+}
+
+} // namespace
+
+const PixelKernels* pixel_kernels_avx2(uint32_t pixel_format) {
+    static const KernelSet set = make_avx2_set();
+    return set.lookup(pixel_format);
+}
+
+#else
+
+const PixelKernels* pixel_kernels_avx2(uint32_t) { return nullptr; }
+
+#endif
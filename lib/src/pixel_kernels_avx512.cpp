@@ -0,0 +1,104 @@
+// AVX-512 (F + BW) kernel variant: hand-written luma and normalize, the rest auto-vectorized
+#include "pixel_kernels_impl.hpp"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+
+// GCC 12's own AVX-512 headers trip its uninitialized checks on their undefined registers (PR105593)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace {
+
+// 16 BGRA pixels, one per 32-bit lane -> 16 luma values in 32-bit lanes
+inline __m512i luma_bgra(__m512i px) {
+    const __m512i low_bytes = _mm512_set1_epi32(0x00FF00FF);
+    const __m512i w_br = _mm512_set1_epi32(static_cast<int>((kWeightR << 16) | kWeightB));
+    const __m512i w_ga = _mm512_set1_epi32(static_cast<int>(kWeightG));
+
+    const __m512i br = _mm512_and_si512(px, low_bytes);
+    const __m512i ga = _mm512_and_si512(_mm512_srli_epi32(px, 8), low_bytes);
+    const __m512i sum = _mm512_add_epi32(_mm512_madd_epi16(br, w_br), _mm512_madd_epi16(ga, w_ga));
+    return _mm512_srli_epi32(_mm512_add_epi32(sum, _mm512_set1_epi32(128)), 8);
+}
+
+template <int C>
+void to_gray_u8(const void* src, void* dst, size_t n) {
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    uint8_t* d = static_cast<uint8_t*>(dst);
+
+    // spreads 4 packed BGR pixels into BGR0 lanes, per 128-bit quarter
+    const __m512i expand = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+    // BGR reads four 16 byte quarters 12 bytes apart
+    constexpr size_t kReadBytes = C == 3 ? 52 : 64;
+
+    size_t i = 0;
+    for (; i * C + kReadBytes <= n * C; i += 16) {
+        __m512i px;
+        if constexpr (C == 3) {
+            const uint8_t* p = s + i * 3;
+            px = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+            px = _mm512_inserti32x4(px, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+            px = _mm512_inserti32x4(px, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 24)), 2);
+            px = _mm512_inserti32x4(px, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 36)), 3);
+            px = _mm512_shuffle_epi8(px, expand);
+        } else {
+            px = _mm512_loadu_si512(s + i * 4);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm512_cvtepi32_epi8(luma_bgra(px)));
+    }
+    GenericKernels<uint8_t, C>::to_gray(s + i * C, d + i, n - i);
+}
+
+template <typename T, int C>
+void normalize(const void* src, float* dst, size_t n) {
+    const T* s = static_cast<const T*>(src);
+    const size_t samples = n * C;
+    const __m512 scale = _mm512_set1_ps(DepthTraits<T>::kInvMax);
+
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16) {
+        __m512i wide;
+        if constexpr (sizeof(T) == 1)
+            wide = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+        else
+            wide = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)));
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_cvtepi32_ps(wide), scale));
+    }
+    for (; i < samples; ++i)
+        dst[i] = static_cast<float>(s[i]) * DepthTraits<T>::kInvMax;
+}
+
+template <typename T, int C>
+void install(PixelKernels& k) {
+    if constexpr (sizeof(T) == 1 && C != 1) k.to_gray = &to_gray_u8<C>;
+    k.normalize = &normalize<T, C>;
+}
+
+KernelSet make_avx512_set() {
+    KernelSet set = make_generic_set();
+    install<uint8_t, 1>(set.u8[1]);
+    install<uint8_t, 3>(set.u8[3]);
+    install<uint8_t, 4>(set.u8[4]);
+    install<uint16_t, 1>(set.u16[1]);
+    install<uint16_t, 3>(set.u16[3]);
+    install<uint16_t, 4>(set.u16[4]);
+    return set;
+}
+
+} // namespace
+
+const PixelKernels* pixel_kernels_avx512(uint32_t pixel_format) {
+    static const KernelSet set = make_avx512_set();
+    return set.lookup(pixel_format);
+}
+
+#else
+
+const PixelKernels* pixel_kernels_avx512(uint32_t) { return nullptr; }
+
+#endif
@@ -0,0 +1,154 @@
+// Portable kernel bodies shared by every pixel_kernels_*.cpp variant.
+//
+// Each variant compiles this header with its own -m flags, so the compiler vectorizes the
+// loops for that instruction set. Everything lives in an anonymous namespace on purpose:
+// identical template instantiations built with different flags must not be merged by the
+// linker, or an AVX-512 body could end up behind the scalar table.
+#pragma once
+#include "pixel_kernels.hpp"
+#include <cstring>
+
+namespace {
+
+// OpenCV's pixel_format encoding: depth in the low 3 bits, channels - 1 above them
+constexpr uint32_t kDepth8U = 0;
+constexpr uint32_t kDepth16U = 2;
+
+// fixed-point BT.601 luma weights in 1/256 units, B + G + R == 256
+constexpr uint32_t kWeightB = 29;
+constexpr uint32_t kWeightG = 150;
+constexpr uint32_t kWeightR = 77;
+
+template <typename T> struct DepthTraits;
+
+template <> struct DepthTraits<uint8_t> {
+    static constexpr float kInvMax = 1.0f / 255.0f;
+    static constexpr int kHistShift = 0;
+};
+
+template <> struct DepthTraits<uint16_t> {
+    static constexpr float kInvMax = 1.0f / 65535.0f;
+    static constexpr int kHistShift = 8;
+};
+
+template <typename T>
+inline T luma(uint32_t b, uint32_t g, uint32_t r) {
+    return static_cast<T>((b * kWeightB + g * kWeightG + r * kWeightR + 128) >> 8);
+}
+
+// Generic kernels, specialized per depth (T) and channel count (C) at compile time
+template <typename T, int C>
+struct GenericKernels {
+    static_assert(C == 1 || C == 3 || C == 4, "unsupported channel count");
+
+    static void to_gray(const void* src, void* dst, size_t n) {
+        const T* s = static_cast<const T*>(src);
+        T* d = static_cast<T*>(dst);
+
+        if constexpr (C == 1) {
+            std::memcpy(d, s, n * sizeof(T));
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                d[i] = luma<T>(s[i * C], s[i * C + 1], s[i * C + 2]);
+        }
+    }
+
+    static void split(const void* src, void* const* dst, size_t n) {
+        const T* s = static_cast<const T*>(src);
+
+        if constexpr (C == 1) {
+            std::memcpy(dst[0], s, n * sizeof(T));
+        } else {
+            T* planes[C];
+            for (int c = 0; c < C; ++c) planes[c] = static_cast<T*>(dst[c]);
+
+            for (size_t i = 0; i < n; ++i)
+                for (int c = 0; c < C; ++c)
+                    planes[c][i] = s[i * C + c];
+        }
+    }
+
+    static void normalize(const void* src, float* dst, size_t n) {
+        const T* s = static_cast<const T*>(src);
+        const size_t samples = n * C;
+        for (size_t i = 0; i < samples; ++i)
+            dst[i] = static_cast<float>(s[i]) * DepthTraits<T>::kInvMax;
+    }
+
+    static void downscale2x(const void* src, size_t src_stride, void* dst,
+                            size_t width, size_t height) {
+        const uint8_t* base = static_cast<const uint8_t*>(src);
+        T* d = static_cast<T*>(dst);
+        const size_t out_w = width / 2;
+        const size_t out_h = height / 2;
+
+        for (size_t y = 0; y < out_h; ++y) {
+            const T* row0 = reinterpret_cast<const T*>(base + (2 * y) * src_stride);
+            const T* row1 = reinterpret_cast<const T*>(base + (2 * y + 1) * src_stride);
+            T* out = d + y * out_w * C;
+
+            for (size_t x = 0; x < out_w; ++x) {
+                for (int c = 0; c < C; ++c) {
+                    const uint32_t sum = uint32_t(row0[2 * x * C + c]) + row0[(2 * x + 1) * C + c]
+                                       + row1[2 * x * C + c] + row1[(2 * x + 1) * C + c];
+                    out[x * C + c] = static_cast<T>((sum + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    // four sub-histograms break the read-modify-write dependency on repeated values
+    static void histogram(const void* src, size_t n, uint32_t* bins) {
+        const T* s = static_cast<const T*>(src);
+        constexpr int shift = DepthTraits<T>::kHistShift;
+
+        uint32_t sub[4][256] = {};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            ++sub[0][s[i] >> shift];
+            ++sub[1][s[i + 1] >> shift];
+            ++sub[2][s[i + 2] >> shift];
+            ++sub[3][s[i + 3] >> shift];
+        }
+        for (; i < n; ++i) ++sub[0][s[i] >> shift];
+
+        for (int b = 0; b < 256; ++b)
+            bins[b] = sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+    }
+};
+
+template <typename T, int C>
+PixelKernels make_generic_kernels() {
+    using K = GenericKernels<T, C>;
+    return PixelKernels{sizeof(T), C, &K::to_gray, &K::split, &K::normalize,
+                        &K::downscale2x, &K::histogram};
+}
+
+// Every supported layout of one variant, indexed by channel count
+struct KernelSet {
+    PixelKernels u8[5];
+    PixelKernels u16[5];
+
+    const PixelKernels* lookup(uint32_t pixel_format) const {
+        const uint32_t depth = pixel_format & 7u;
+        const uint32_t channels = (pixel_format >> 3) + 1;
+        if (channels != 1 && channels != 3 && channels != 4) return nullptr;
+
+        if (depth == kDepth8U)  return &u8[channels];
+        if (depth == kDepth16U) return &u16[channels];
+        return nullptr;
+    }
+};
+
+inline KernelSet make_generic_set() {
+    KernelSet set{};
+    set.u8[1] = make_generic_kernels<uint8_t, 1>();
+    set.u8[3] = make_generic_kernels<uint8_t, 3>();
+    set.u8[4] = make_generic_kernels<uint8_t, 4>();
+    set.u16[1] = make_generic_kernels<uint16_t, 1>();
+    set.u16[3] = make_generic_kernels<uint16_t, 3>();
+    set.u16[4] = make_generic_kernels<uint16_t, 4>();
+    return set;
+}
+
+} // namespace
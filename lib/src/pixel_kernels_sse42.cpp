@@ -0,0 +1,92 @@
+// SSE4.2 kernel variant: hand-written luma and normalize, the rest auto-vectorized
+#include "pixel_kernels_impl.hpp"
+
+#if defined(__SSE4_2__)
+#include <immintrin.h>
+
+namespace {
+
+// 4 BGRA pixels, one per 32-bit lane -> 4 luma values in 32-bit lanes
+inline __m128i luma_bgra(__m128i px) {
+    const __m128i low_bytes = _mm_set1_epi32(0x00FF00FF);
+    const __m128i w_br = _mm_set1_epi32(static_cast<int>((kWeightR << 16) | kWeightB));
+    const __m128i w_ga = _mm_set1_epi32(static_cast<int>(kWeightG));
+
+    const __m128i br = _mm_and_si128(px, low_bytes);
+    const __m128i ga = _mm_and_si128(_mm_srli_epi32(px, 8), low_bytes);
+    const __m128i sum = _mm_add_epi32(_mm_madd_epi16(br, w_br), _mm_madd_epi16(ga, w_ga));
+    return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+}
+
+template <int C>
+void to_gray_u8(const void* src, void* dst, size_t n) {
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    uint8_t* d = static_cast<uint8_t*>(dst);
+
+    // spreads 4 packed BGR pixels into BGR0 lanes
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+    size_t i = 0;
+    for (; i * C + 16 <= n * C; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * C));
+        if constexpr (C == 3) px = _mm_shuffle_epi8(px, expand);
+
+        const __m128i g32 = luma_bgra(px);
+        const __m128i g8 = _mm_packus_epi16(_mm_packus_epi32(g32, g32), g32);
+        const int packed = _mm_cvtsi128_si32(g8);
+        std::memcpy(d + i, &packed, 4);
+    }
+    GenericKernels<uint8_t, C>::to_gray(s + i * C, d + i, n - i);
+}
+
+template <typename T, int C>
+void normalize(const void* src, float* dst, size_t n) {
+    const T* s = static_cast<const T*>(src);
+    const size_t samples = n * C;
+    const __m128 scale = _mm_set1_ps(DepthTraits<T>::kInvMax);
+
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        __m128i wide;
+        if constexpr (sizeof(T) == 1) {
+            int four;
+            std::memcpy(&four, s + i, 4);
+            wide = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(four));
+        } else {
+            wide = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i)));
+        }
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(wide), scale));
+    }
+    for (; i < samples; ++i)
+        dst[i] = static_cast<float>(s[i]) * DepthTraits<T>::kInvMax;
+}
+
+template <typename T, int C>
+void install(PixelKernels& k) {
+    if constexpr (sizeof(T) == 1 && C != 1) k.to_gray = &to_gray_u8<C>;
+    k.normalize = &normalize<T, C>;
+}
+
+KernelSet make_sse42_set() {
+    KernelSet set = make_generic_set();
+    install<uint8_t, 1>(set.u8[1]);
+    install<uint8_t, 3>(set.u8[3]);
+    install<uint8_t, 4>(set.u8[4]);
+    install<uint16_t, 1>(set.u16[1]);
+    install<uint16_t, 3>(set.u16[3]);
+    install<uint16_t, 4>(set.u16[4]);
+    return set;
+}
+
+} // namespace
+
+const PixelKernels* pixel_kernels_sse42(uint32_t pixel_format) {
+    static const KernelSet set = make_sse42_set();
+    return set.lookup(pixel_format);
+}
+
+#else
+
+const PixelKernels* pixel_kernels_sse42(uint32_t) { return nullptr; }
+
+#endif
@@ -0,0 +1,233 @@
+#include "runtime_profile.hpp"
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::vector<int> parse_cpu_list(const std::string& text) {
+    std::set<int> cpus;
+    std::istringstream in(text);
+    std::string item;
+
+    while (std::getline(in, item, ',')) {
+        item.erase(std::remove_if(item.begin(), item.end(), ::isspace), item.end());
+        if (item.empty()) continue;
+
+        try {
+            const size_t dash = item.find('-');
+            const int first = std::stoi(item.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            if (first < 0 || last < first) throw std::invalid_argument(item);
+            for (int cpu = first; cpu <= last; ++cpu) cpus.insert(cpu);
+        } catch (const std::exception&) {
+            std::cerr << "[WARN] Ignoring malformed CPU list entry '" << item << "'\n";
+        }
+    }
+    return {cpus.begin(), cpus.end()};
+}
+
+// collapses runs, so {0,1,2,3,6} reads back as "0-3,6"
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::ostringstream out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (i) out << ",";
+        out << cpus[i];
+        if (j > i) out << "-" << cpus[j];
+        i = j + 1;
+    }
+    return out.str();
+}
+
+RuntimeProfile loadRuntimeProfile(const std::string& stage, const std::string& path) {
+    RuntimeProfile profile;
+
+    YAML::Node root;
+    try {
+        root = YAML::LoadFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Failed to load runtime profile from " << path
+                  << " (" << e.what() << "), leaving placement to the OS\n";
+        return profile;
+    }
+
+    const auto& p = root["runtime"][stage];
+    if (!p) return profile;
+
+    if (p["cpus"])              profile.cpus = parse_cpu_list(p["cpus"].as<std::string>());
+    if (p["numa_local"])        profile.numa_local = p["numa_local"].as<bool>();
+    if (p["busy_poll"])         profile.busy_poll = p["busy_poll"].as<bool>();
+    if (p["realtime_priority"]) profile.realtime_priority = p["realtime_priority"].as<int>();
+
+    return profile;
+}
+
+#if defined(__linux__)
+
+// NUMA node of a CPU from sysfs (cpuN/nodeK), -1 if the kernel does not say
+static int cpu_node(int cpu) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/sys/devices/system/cpu/cpu" + std::to_string(cpu), ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0) {
+            try { return std::stoi(name.substr(4)); } catch (const std::exception&) {}
+        }
+    }
+    return -1;
+}
+
+static std::vector<int> current_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    return cpus;
+}
+
+static bool pin(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        std::cerr << "[Runtime] Pinning to CPUs " << format_cpu_list(cpus) << " failed: "
+                  << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Prefers (rather than binds to) the node, so a full node falls back instead of failing
+static bool prefer_node(int node) {
+    unsigned long mask = 1UL << node;
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8) != 0) {
+        std::cerr << "[Runtime] Preferring NUMA node " << node << " failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+static std::string describe_mempolicy() {
+    int mode = 0;
+    unsigned long mask = 0;
+    if (syscall(SYS_get_mempolicy, &mode, &mask, sizeof(mask) * 8, nullptr, 0) != 0)
+        return "unknown";
+
+    switch (mode & ~(MPOL_F_STATIC_NODES | MPOL_F_RELATIVE_NODES)) {
+    case MPOL_DEFAULT:    return "local";
+    case MPOL_PREFERRED:  return mask ? "node " + std::to_string(__builtin_ctzl(mask)) + " preferred" : "local";
+    case MPOL_BIND:       return "bound";
+    case MPOL_INTERLEAVE: return "interleaved";
+    }
+    return "mode " + std::to_string(mode);
+}
+
+static bool set_fifo(int priority) {
+    sched_param param{};
+    param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO),
+                                      sched_get_priority_max(SCHED_FIFO));
+    const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        std::cerr << "[Runtime] SCHED_FIFO " << param.sched_priority << " refused: " << std::strerror(rc)
+                  << (rc == EPERM ? " (needs CAP_SYS_NICE or an rtprio limit)" : "") << "\n";
+        return false;
+    }
+    return true;
+}
+
+static std::string describe_scheduling() {
+    int policy = 0;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0) return "unknown";
+    if (policy == SCHED_FIFO) return "SCHED_FIFO " + std::to_string(param.sched_priority);
+    if (policy == SCHED_RR)   return "SCHED_RR " + std::to_string(param.sched_priority);
+    return "SCHED_OTHER";
+}
+
+void applyRuntimeProfile(const std::string& stage, const RuntimeProfile& profile) {
+    if (!profile.cpus.empty()) pin(profile.cpus);
+
+    if (profile.numa_local) {
+        std::set<int> nodes;
+        for (int cpu : current_cpus()) nodes.insert(cpu_node(cpu));
+
+        if (nodes.size() == 1 && *nodes.begin() >= 0) {
+            prefer_node(*nodes.begin());
+        } else {
+            // pinned threads already allocate locally by default; with CPUs on several nodes
+            // there is no single node to prefer
+            std::cerr << "[Runtime] " << stage << " CPUs span " << nodes.size()
+                      << " NUMA nodes, keeping local allocation\n";
+        }
+    }
+
+    // what the kernel actually granted, not what was asked for
+    std::set<int> nodes;
+    const std::vector<int> cpus = current_cpus();
+    for (int cpu : cpus)
+        if (cpu_node(cpu) >= 0) nodes.insert(cpu_node(cpu));
+
+    std::cout << "[Runtime] " << stage << ": CPUs " << format_cpu_list(cpus)
+              << (profile.cpus.empty() ? " (unpinned)" : "")
+              << " | NUMA " << (nodes.empty() ? "unknown" : format_cpu_list({nodes.begin(), nodes.end()}))
+              << ", memory " << describe_mempolicy()
+              << " | " << (profile.busy_poll ? "busy-poll" : "blocking") << " sockets" << std::endl;
+}
+
+// FIFO threads at one priority never time-slice, so a spinning one keeps its CPU for good
+void applyRealtimePriority(const std::string& thread, const RuntimeProfile& profile) {
+    if (profile.realtime_priority <= 0) return;
+
+    if (profile.busy_poll && usable_cpu_count() < 2) {
+        std::cerr << "[Runtime] " << thread << ": not using SCHED_FIFO, a busy-polling thread at "
+                  << "that priority would starve the stage's other threads on its single CPU\n";
+        return;
+    }
+    set_fifo(profile.realtime_priority);
+    std::cout << "[Runtime] " << thread << ": " << describe_scheduling() << std::endl;
+}
+
+size_t usable_cpu_count() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0)
+        return static_cast<size_t>(CPU_COUNT(&set));
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+#else
+
+// Thread placement is a Linux feature here; elsewhere only busy-polling applies
+void applyRuntimeProfile(const std::string& stage, const RuntimeProfile& profile) {
+    if (!profile.cpus.empty() || profile.numa_local || profile.realtime_priority > 0)
+        std::cerr << "[Runtime] " << stage << ": CPU pinning, NUMA and SCHED_FIFO are only supported on Linux\n";
+
+    std::cout << "[Runtime] " << stage << ": placement left to the OS | "
+              << (profile.busy_poll ? "busy-poll" : "blocking") << " sockets" << std::endl;
+}
+
+void applyRealtimePriority(const std::string&, const RuntimeProfile&) {}
+
+size_t usable_cpu_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+#endif
@@ -1,20 +1,37 @@
 #include "shutdown_handler.hpp"
+#include "wait_word.hpp"
 #include <string>
 #include <iostream>
 #include <atomic>
 #include <csignal>
+#include <pthread.h>
+#include <thread>
 
 // Definition of static member
 std::atomic<bool> ShutdownHandler::keep_running(true);
+std::atomic<WaitWord*> ShutdownHandler::wakeups[ShutdownHandler::kMaxWakeups] = {};
+std::atomic<uint64_t> ShutdownHandler::trace_dump_requests(0);
+std::atomic<WaitWord*> ShutdownHandler::trace_dump_wakeup(nullptr);
 
-// Install handlers for all relevant signals
+// Install handlers for all relevant signals. Must run before any other thread is started.
 void ShutdownHandler::init() {
     std::signal(SIGINT,  handle_signal);   // Ctrl + C
     std::signal(SIGTERM, handle_signal);   // system kill
     std::signal(SIGQUIT, handle_signal);   // Ctrl + backslash
     std::signal(SIGHUP,  handle_signal);   // terminal death or reload
-    std::signal(SIGUSR1, handle_signal);   // user hook
     std::signal(SIGUSR2, handle_signal);   // user hook
+
+    // SIGUSR1 (trace dump) keeps the stage running, so it must not interrupt a blocking
+    // call either: zmq turns EINTR into an exception that ends the receive loop. It is
+    // blocked here, inherited by every thread started later, and taken by sigwait instead.
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &usr1, nullptr);
+    std::thread([usr1] {
+        int sig = 0;
+        while (sigwait(&usr1, &sig) == 0) requestTraceDump();
+    }).detach();
 }
 
 // Returns false when shutdown requested
@@ -22,6 +39,48 @@ bool ShutdownHandler::running() {
     return keep_running.load(std::memory_order_relaxed);
 }
 
+void ShutdownHandler::requestShutdown() {
+    keep_running.store(false, std::memory_order_relaxed);
+    wakeRegistered();
+}
+
+bool ShutdownHandler::registerWakeup(WaitWord* word) {
+    for (auto& slot : wakeups) {
+        WaitWord* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, word)) return true;
+    }
+    std::cerr << "[ShutdownHandler] No wakeup slot left\n";
+    return false;
+}
+
+void ShutdownHandler::unregisterWakeup(WaitWord* word) {
+    for (auto& slot : wakeups) {
+        WaitWord* expected = word;
+        if (slot.compare_exchange_strong(expected, nullptr)) return;
+    }
+}
+
+uint64_t ShutdownHandler::traceDumpRequests() {
+    return trace_dump_requests.load(std::memory_order_acquire);
+}
+
+void ShutdownHandler::setTraceDumpWakeup(WaitWord* word) {
+    trace_dump_wakeup.store(word);
+}
+
+void ShutdownHandler::requestTraceDump() {
+    std::cerr << "\n[ShutdownHandler] Caught SIGUSR1, dumping trace.\n";
+    trace_dump_requests.fetch_add(1, std::memory_order_release);
+    if (WaitWord* word = trace_dump_wakeup.load()) word->wakeAll();
+}
+
+// Lock-free and syscall-only, so it is safe to run inside the signal handler
+void ShutdownHandler::wakeRegistered() {
+    for (auto& slot : wakeups) {
+        if (WaitWord* word = slot.load()) word->wakeAll();
+    }
+}
+
 void ShutdownHandler::handle_signal(int sig) {
     switch (sig) {
     case SIGINT:
@@ -36,9 +95,6 @@ void ShutdownHandler::handle_signal(int sig) {
     case SIGHUP:
         std::cerr << "\n[ShutdownHandler] Caught SIGHUP (terminal closed or reload request).\n";
         break;
-    case SIGUSR1:
-        std::cerr << "\n[ShutdownHandler] Caught SIGUSR1.\n";
-        break;
     case SIGUSR2:
         std::cerr << "\n[ShutdownHandler] Caught SIGUSR2.\n";
         break;
@@ -48,4 +104,5 @@ void ShutdownHandler::handle_signal(int sig) {
     }
 
     keep_running.store(false, std::memory_order_relaxed);
+    wakeRegistered();
 }
\ No newline at end of file
@@ -0,0 +1,282 @@
+#include "trace.hpp"
+#include "shutdown_handler.hpp"
+#include "wait_word.hpp"
+#include <yaml-cpp/yaml.h>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> frame{0};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+    std::atomic<uint32_t> frames{0};
+};
+
+// One thread's spans. Only the owning thread writes; a dump reads concurrently and throws
+// away whatever the writer may have overwritten meanwhile (begun/ended work like a seqlock).
+struct ThreadRing {
+    ThreadRing(size_t events, uint32_t tid) : tid(tid) {
+        size_t capacity = 2;
+        while (capacity < events) capacity <<= 1;
+        mask = capacity - 1;
+        slots.reset(new Slot[capacity]);
+    }
+
+    size_t mask = 0;
+    std::unique_ptr<Slot[]> slots;
+    const uint32_t tid;
+
+    alignas(64) std::atomic<uint64_t> begun{0};    // slots the writer has started on
+    std::atomic<uint64_t> ended{0};                // slots fully written
+
+    std::mutex name_mtx;
+    std::string name;
+};
+
+struct Event {
+    const char* name;
+    uint64_t frame, start_ns, end_ns;
+    uint32_t frames;
+};
+
+// checked on every span, so it lives outside the lazily built registry
+std::atomic<bool> g_enabled{false};
+
+struct Registry {
+    std::mutex mtx;
+    std::vector<std::shared_ptr<ThreadRing>> rings;    // kept after their thread exits
+    uint32_t next_tid = 1;
+
+    TraceConfig cfg;
+    std::string process_name;
+    int sessions = 0;
+    uint32_t dumps = 0;
+
+    std::thread exporter;
+    WaitWord dump_word;
+    std::atomic<bool> stopping{false};
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+thread_local std::shared_ptr<ThreadRing> t_ring;
+
+ThreadRing& localRing() {
+    if (!t_ring) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mtx);
+        t_ring = std::make_shared<ThreadRing>(r.cfg.events_per_thread, r.next_tid++);
+        r.rings.push_back(t_ring);
+    }
+    return *t_ring;
+}
+
+// Copies out the spans that were complete and not overwritten while being read
+void snapshot(ThreadRing& ring, std::vector<Event>& out) {
+    const uint64_t capacity = ring.mask + 1;
+    const uint64_t end = ring.ended.load(std::memory_order_acquire);
+    const uint64_t first = end > capacity ? end - capacity : 0;
+
+    const size_t base = out.size();
+    for (uint64_t i = first; i < end; ++i) {
+        const Slot& s = ring.slots[i & ring.mask];
+        out.push_back({s.name.load(std::memory_order_relaxed), s.frame.load(std::memory_order_relaxed),
+                       s.start_ns.load(std::memory_order_relaxed), s.end_ns.load(std::memory_order_relaxed),
+                       s.frames.load(std::memory_order_relaxed)});
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t begun = ring.begun.load(std::memory_order_relaxed);
+
+    // slot i is reused by write i + capacity; anything the writer has begun on since is stale
+    size_t keep = base;
+    for (uint64_t i = first; i < end; ++i) {
+        if (i + capacity >= begun && out[base + (i - first)].name)
+            out[keep++] = out[base + (i - first)];
+    }
+    out.resize(keep);
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+void exporterLoop() {
+    Registry& r = registry();
+    uint64_t handled = ShutdownHandler::traceDumpRequests();
+
+    while (true) {
+        const uint32_t seen = r.dump_word.prepare();
+        const uint64_t requested = ShutdownHandler::traceDumpRequests();
+        if (requested != handled) {
+            r.dump_word.cancel();
+            handled = requested;
+            trace_dump();
+            continue;
+        }
+        if (r.stopping.load()) {
+            r.dump_word.cancel();
+            break;
+        }
+        r.dump_word.wait(seen, 1000000);
+    }
+}
+
+} // namespace
+
+TraceConfig loadTraceConfig(const std::string& path) {
+    TraceConfig cfg;
+
+    YAML::Node root;
+    try {
+        root = YAML::LoadFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Failed to load trace config from " << path
+                  << " (" << e.what() << "), using defaults\n";
+        return cfg;
+    }
+
+    const auto& t = root["trace"];
+    if (!t) return cfg;
+
+    if (t["enabled"])           cfg.enabled = t["enabled"].as<bool>();
+    if (t["events_per_thread"]) cfg.events_per_thread = t["events_per_thread"].as<size_t>();
+    if (t["output_dir"])        cfg.output_dir = t["output_dir"].as<std::string>();
+    if (t["dump_on_exit"])      cfg.dump_on_exit = t["dump_on_exit"].as<bool>();
+
+    return cfg;
+}
+
+bool trace_enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void trace_record(const char* name, uint64_t frame, uint64_t start_ns, uint64_t end_ns, uint32_t frames) {
+    ThreadRing& ring = localRing();
+    const uint64_t i = ring.ended.load(std::memory_order_relaxed);
+    Slot& s = ring.slots[i & ring.mask];
+
+    ring.begun.store(i + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    s.name.store(name, std::memory_order_relaxed);
+    s.frame.store(frame, std::memory_order_relaxed);
+    s.start_ns.store(start_ns, std::memory_order_relaxed);
+    s.end_ns.store(end_ns, std::memory_order_relaxed);
+    s.frames.store(frames, std::memory_order_relaxed);
+
+    ring.ended.store(i + 1, std::memory_order_release);
+}
+
+void trace_thread_name(const std::string& name) {
+    ThreadRing& ring = localRing();
+    std::lock_guard<std::mutex> lock(ring.name_mtx);
+    ring.name = name;
+}
+
+std::string trace_dump() {
+    Registry& r = registry();
+
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(r.mtx);
+        rings = r.rings;
+        path = r.cfg.output_dir + "/trace_" + r.process_name + "_" + std::to_string(getpid())
+             + "_" + std::to_string(r.dumps++) + ".json";
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "[Trace] Cannot write " << path << std::endl;
+        return {};
+    }
+
+    const int pid = getpid();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+        << ",\"args\":{\"name\":\"" << jsonEscape(r.process_name) << "\"}}";
+
+    size_t written = 0;
+    std::vector<Event> events;
+    for (const auto& ring : rings) {
+        {
+            std::lock_guard<std::mutex> lock(ring->name_mtx);
+            if (!ring->name.empty())
+                out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << ring->tid
+                    << ",\"args\":{\"name\":\"" << jsonEscape(ring->name) << "\"}}";
+        }
+
+        events.clear();
+        snapshot(*ring, events);
+        for (const Event& e : events) {
+            // complete events, timestamps in microseconds
+            out << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":" << pid
+                << ",\"tid\":" << ring->tid
+                << ",\"ts\":" << e.start_ns / 1000.0
+                << ",\"dur\":" << (e.end_ns - e.start_ns) / 1000.0
+                << ",\"args\":{\"frame\":" << e.frame;
+            if (e.frames > 1) out << ",\"frames\":" << e.frames;
+            out << "}}";
+        }
+        written += events.size();
+    }
+    out << "\n]}\n";
+
+    std::cout << "[Trace] Wrote " << written << " spans from " << rings.size() << " threads to "
+              << path << std::endl;
+    return path;
+}
+
+TraceSession::TraceSession(const std::string& process_name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    if (r.sessions++ > 0) return;
+
+    r.cfg = loadTraceConfig();
+    r.process_name = process_name;
+    if (!r.cfg.enabled) return;
+
+    g_enabled.store(true, std::memory_order_relaxed);
+    r.stopping = false;
+    ShutdownHandler::setTraceDumpWakeup(&r.dump_word);
+    r.exporter = std::thread(exporterLoop);
+
+    std::cout << "[Trace] Recording " << r.cfg.events_per_thread << " spans per thread, kill -USR1 "
+              << getpid() << " writes them to " << r.cfg.output_dir << std::endl;
+}
+
+TraceSession::~TraceSession() {
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mtx);
+        if (--r.sessions > 0 || !r.exporter.joinable()) return;
+    }
+
+    ShutdownHandler::setTraceDumpWakeup(nullptr);
+    r.stopping = true;
+    r.dump_word.wakeAll();
+    r.exporter.join();
+
+    if (r.cfg.dump_on_exit) trace_dump();
+    g_enabled.store(false, std::memory_order_relaxed);
+}
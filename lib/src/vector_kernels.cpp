@@ -0,0 +1,50 @@
+// Scalar distance kernels and dispatch. Built without auto-vectorization like the scalar
+// pixel kernels, so it stays the reference the SIMD variants are checked against.
+#include "vector_kernels.hpp"
+
+// defined by the per instruction set translation units, nullptr when built without the ISA
+const VectorKernels* vector_kernels_sse42();
+const VectorKernels* vector_kernels_avx2();
+const VectorKernels* vector_kernels_avx512();
+
+namespace {
+
+float l2_squared(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        const float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+void l2_squared_many(const float* query, const float* base, size_t count, size_t stride, float* out) {
+    for (size_t j = 0; j < count; ++j) out[j] = l2_squared(query, base + j * stride, stride);
+}
+
+const VectorKernels kScalar = {l2_squared, l2_squared_many};
+
+} // namespace
+
+const VectorKernels& vector_kernels() {
+    static const VectorKernels& kernels = vector_kernels(active_simd_level());
+    return kernels;
+}
+
+// Falls back one level at a time when a variant was not compiled in (e.g. non-x86 builds)
+const VectorKernels& vector_kernels(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512:
+        if (const VectorKernels* k = vector_kernels_avx512()) return *k;
+        [[fallthrough]];
+    case SimdLevel::AVX2:
+        if (const VectorKernels* k = vector_kernels_avx2()) return *k;
+        [[fallthrough]];
+    case SimdLevel::SSE42:
+        if (const VectorKernels* k = vector_kernels_sse42()) return *k;
+        [[fallthrough]];
+    case SimdLevel::Scalar:
+        break;
+    }
+    return kScalar;
+}
@@ -0,0 +1,62 @@
+// AVX2 distance kernels, 8 floats per step
+#include "vector_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+inline float hsum(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    return _mm_cvtss_f32(s);
+}
+
+float l2_squared(const float* a, const float* b, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(d, d));
+    }
+    return hsum(acc);
+}
+
+// Feature vectors are short (a few dozen floats), so four candidates are compared per pass
+// to keep independent accumulators in flight instead of one dependent add chain
+void l2_squared_many(const float* query, const float* base, size_t count, size_t stride, float* out) {
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        const float* v = base + j * stride;
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+        for (size_t i = 0; i < stride; i += 8) {
+            const __m256 q = _mm256_loadu_ps(query + i);
+            const __m256 d0 = _mm256_sub_ps(q, _mm256_loadu_ps(v + i));
+            const __m256 d1 = _mm256_sub_ps(q, _mm256_loadu_ps(v + stride + i));
+            const __m256 d2 = _mm256_sub_ps(q, _mm256_loadu_ps(v + 2 * stride + i));
+            const __m256 d3 = _mm256_sub_ps(q, _mm256_loadu_ps(v + 3 * stride + i));
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+            acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(d2, d2));
+            acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(d3, d3));
+        }
+        out[j] = hsum(acc0);
+        out[j + 1] = hsum(acc1);
+        out[j + 2] = hsum(acc2);
+        out[j + 3] = hsum(acc3);
+    }
+    for (; j < count; ++j) out[j] = l2_squared(query, base + j * stride, stride);
+}
+
+const VectorKernels kAvx2 = {l2_squared, l2_squared_many};
+
+} // namespace
+
+const VectorKernels* vector_kernels_avx2() { return &kAvx2; }
+
+#else
+
+const VectorKernels* vector_kernels_avx2() { return nullptr; }
+
+#endif
@@ -0,0 +1,66 @@
+// AVX-512 distance kernels, 16 floats per step with an 8 float tail
+#include "vector_kernels.hpp"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+
+// GCC 12's own AVX-512 headers trip its uninitialized checks on their undefined registers (PR105593)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace {
+
+inline float hsum(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    return _mm_cvtss_f32(s);
+}
+
+// n is a multiple of 8: whole 16 float steps, then at most one 8 float step
+inline __m512 l2_partial(const float* a, const float* b, size_t n, float& tail) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(d, d));
+    }
+    tail = 0.0f;
+    if (i < n) {
+        const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        tail = hsum(_mm256_mul_ps(d, d));
+    }
+    return acc;
+}
+
+float l2_squared(const float* a, const float* b, size_t n) {
+    float tail;
+    const __m512 acc = l2_partial(a, b, n, tail);
+    return _mm512_reduce_add_ps(acc) + tail;
+}
+
+void l2_squared_many(const float* query, const float* base, size_t count, size_t stride, float* out) {
+    size_t j = 0;
+    for (; j + 2 <= count; j += 2) {
+        float tail0, tail1;
+        const __m512 acc0 = l2_partial(query, base + j * stride, stride, tail0);
+        const __m512 acc1 = l2_partial(query, base + (j + 1) * stride, stride, tail1);
+        out[j] = _mm512_reduce_add_ps(acc0) + tail0;
+        out[j + 1] = _mm512_reduce_add_ps(acc1) + tail1;
+    }
+    for (; j < count; ++j) out[j] = l2_squared(query, base + j * stride, stride);
+}
+
+const VectorKernels kAvx512 = {l2_squared, l2_squared_many};
+
+} // namespace
+
+const VectorKernels* vector_kernels_avx512() { return &kAvx512; }
+
+#else
+
+const VectorKernels* vector_kernels_avx512() { return nullptr; }
+
+#endif
@@ -0,0 +1,37 @@
+// SSE4.2 distance kernels, 4 floats per step
+#include "vector_kernels.hpp"
+
+#if defined(__SSE4_2__)
+#include <immintrin.h>
+
+namespace {
+
+float l2_squared(const float* a, const float* b, size_t n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        const __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        const __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_hadd_ps(acc, acc);
+    acc = _mm_hadd_ps(acc, acc);
+    return _mm_cvtss_f32(acc);
+}
+
+void l2_squared_many(const float* query, const float* base, size_t count, size_t stride, float* out) {
+    for (size_t j = 0; j < count; ++j) out[j] = l2_squared(query, base + j * stride, stride);
+}
+
+const VectorKernels kSse42 = {l2_squared, l2_squared_many};
+
+} // namespace
+
+const VectorKernels* vector_kernels_sse42() { return &kSse42; }
+
+#else
+
+const VectorKernels* vector_kernels_sse42() { return nullptr; }
+
+#endif
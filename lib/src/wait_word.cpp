@@ -0,0 +1,54 @@
+#include "wait_word.hpp"
+#include <ctime>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futex needs a plain 32-bit word");
+
+#if defined(__linux__)
+
+// private futexes: the word is never shared with another process
+static long futex(std::atomic<uint32_t>* word, int op, uint32_t val, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op | FUTEX_PRIVATE_FLAG,
+                   val, timeout, nullptr, 0);
+}
+
+void WaitWord::wait(uint32_t seen, uint32_t timeout_us) {
+    timespec timeout{};
+    timeout.tv_sec = timeout_us / 1000000;
+    timeout.tv_nsec = static_cast<long>(timeout_us % 1000000) * 1000;
+
+    // returns at once (EAGAIN) if the word moved on since seen was read
+    futex(&value, FUTEX_WAIT, seen, timeout_us ? &timeout : nullptr);
+}
+
+// The count is taken before the word is bumped: a waiter counted here either reads seen
+// after the bump and does not sleep, or is already queued on the futex when the wake comes
+void WaitWord::wakeAll() {
+    const uint32_t waiting = sleepers.exchange(0, std::memory_order_seq_cst);
+    value.fetch_add(1, std::memory_order_seq_cst);
+    if (waiting != 0)
+        futex(&value, FUTEX_WAKE, INT32_MAX, nullptr);
+}
+
+#else
+
+void WaitWord::wait(uint32_t seen, uint32_t timeout_us) {
+    if (value.load(std::memory_order_seq_cst) == seen) {
+        const uint32_t nap_us = (timeout_us && timeout_us < kFallbackNapUs) ? timeout_us : kFallbackNapUs;
+        timespec nap{0, static_cast<long>(nap_us) * 1000};
+        nanosleep(&nap, nullptr);
+    }
+}
+
+void WaitWord::wakeAll() {
+    sleepers.store(0, std::memory_order_seq_cst);
+    value.fetch_add(1, std::memory_order_seq_cst);
+}
+
+#endif
@@ -0,0 +1,81 @@
+#include "shared.hpp"
+#include "shutdown_handler.hpp"
+#include "generator_stage.hpp"
+#include "extractor_stage.hpp"
+#include "logger_stage.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <zmq.hpp>
+
+// Runs image_generator, feature_extractor and data_logger as thread groups of one process.
+// The stages share one zmq context and talk over inproc:// endpoints, where a message moves
+// between sockets as a pointer: no kernel copies, no syscalls, no context switches between
+// processes. The image buffer the generator loads is the one the logger finally stores.
+int main(int argc, char* argv[]) {
+
+    const std::string usage = std::string("Usage: ") + argv[0] + " <folder_path> [--encoded] [--workers N]\n";
+    if (argc < 2) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    GeneratorOptions generator;
+    generator.folder = argv[1];
+    size_t num_workers = 0;
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--encoded") {
+            generator.encoded = true;
+        } else if (arg == "--workers" && i + 1 < argc) {
+            try {
+                num_workers = std::max(1, std::stoi(argv[++i]));
+            } catch (const std::exception&) {
+                std::cerr << "Invalid worker count '" << argv[i] << "'\n" << usage;
+                return 1;
+            }
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    print_banner("Pipeline Started");
+
+    // <--- install signal handlers for shutdown, once for all stages
+    ShutdownHandler::init();
+
+    // opened before the stages' own sessions so one exporter writes all their threads
+    // into a single trace named after the pipeline
+    TraceSession tracing("pipeline");
+
+    // mode comes from the pipeline config, the endpoints are always in-process
+    TransportConfig transport = loadTransportConfig();
+    transport.image_endpoint = "inproc://images";
+    transport.features_endpoint = "inproc://features";
+
+    std::cout << "Stages connected over " << transport.image_endpoint << " and "
+              << transport.features_endpoint << " (" << transport_mode_name(transport.mode) << ")\n";
+
+    // inproc needs no I/O threads, the stages' own threads move every message
+    zmq::context_t ctx{0};
+
+    // a stage that gives up takes the others down with it
+    int logger_rc = 0, extractor_rc = 0, generator_rc = 0;
+    auto stopOnFailure = [](int rc) { if (rc != 0) ShutdownHandler::requestShutdown(); return rc; };
+
+    // downstream first, like starting the separate binaries by hand
+    std::thread logger([&] { logger_rc = stopOnFailure(runDataLogger(ctx, transport)); });
+    std::thread extractor([&] { extractor_rc = stopOnFailure(runFeatureExtractor(ctx, transport, num_workers)); });
+    std::thread producer([&] { generator_rc = stopOnFailure(runImageGenerator(ctx, transport, generator)); });
+
+    producer.join();
+    extractor.join();
+    logger.join();
+
+    print_banner("Pipeline Terminated");
+    return (generator_rc || extractor_rc || logger_rc) ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+// Checks and measures the lib/ similarity index (feature_index.hpp):
+//   1. every SIMD variant of the distance kernels against the scalar reference
+//   2. recall@k and query latency of FeatureIndex against a brute-force scan, per probe count
+//   3. that removed images are never returned again
+// Vectors are drawn around random cluster centres in [0, 1], like normalized image features,
+// and queried with slightly perturbed copies of indexed vectors. Exits non-zero if a kernel
+// disagrees or a removed image shows up.
+//
+//   feature_index_bench [images] [dims] [lists] [queries]
+#include "feature_index.hpp"
+#include "vector_kernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kTopK = 10;
+constexpr size_t kCentres = 1000;
+constexpr float kSpread = 0.05f;
+
+std::mt19937 rng(12345);
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Relative tolerance: the variants sum in a different order than the scalar loop
+bool close(float a, float b) {
+    return std::fabs(a - b) <= 1e-5f * std::max(1.0f, std::fabs(a));
+}
+
+bool checkKernels() {
+    const VectorKernels& ref = vector_kernels(SimdLevel::Scalar);
+    const SimdLevel highest = detect_simd_level();
+    std::cout << "CPU supports up to " << simd_level_name(highest) << "\n";
+    std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+
+    bool ok = true;
+    for (int l = static_cast<int>(SimdLevel::SSE42); l <= static_cast<int>(highest); ++l) {
+        const SimdLevel level = static_cast<SimdLevel>(l);
+        const VectorKernels& test = vector_kernels(level);
+        size_t mismatches = 0;
+
+        for (size_t n = kVectorAlign; n <= 520; n += kVectorAlign) {
+            for (size_t count : {1, 2, 7, 33}) {
+                const size_t stride = n + (count % 2) * kVectorAlign;  // some rows with slack
+                std::vector<float> query(stride), base(count * stride);
+                for (float& v : query) v = value(rng);
+                for (float& v : base) v = value(rng);
+
+                std::vector<float> ref_out(count), test_out(count);
+                ref.l2_squared_many(query.data(), base.data(), count, stride, ref_out.data());
+                test.l2_squared_many(query.data(), base.data(), count, stride, test_out.data());
+
+                for (size_t j = 0; j < count; ++j) {
+                    if (!close(ref_out[j], test_out[j])) ++mismatches;
+                    const float single = test.l2_squared(query.data(), base.data() + j * stride, stride);
+                    if (!close(ref_out[j], single)) ++mismatches;
+                }
+            }
+        }
+
+        std::cout << simd_level_name(level) << " distance kernels: "
+                  << (mismatches ? std::to_string(mismatches) + " MISMATCHES" : std::string("OK")) << "\n";
+        ok &= mismatches == 0;
+    }
+    return ok;
+}
+
+// The exact k nearest of the live images, by the scalar kernel
+std::vector<uint64_t> bruteForce(const std::vector<float>& padded, size_t stride, const std::vector<bool>& live,
+                                 const float* query, std::vector<float>& distances) {
+    const size_t n = live.size();
+    distances.resize(n);
+    vector_kernels(SimdLevel::Scalar).l2_squared_many(query, padded.data(), n, stride, distances.data());
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        if (live[i]) order.push_back(static_cast<uint32_t>(i));
+    const size_t k = std::min(kTopK, order.size());
+    std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                      [&](uint32_t a, uint32_t b) { return distances[a] < distances[b]; });
+
+    std::vector<uint64_t> hashes;
+    for (size_t i = 0; i < k; ++i) hashes.push_back(order[i] + 1);  // image i is hash i + 1
+    return hashes;
+}
+
+struct Result {
+    double recall;
+    double mean_us;
+    double p99_us;
+    size_t removed_hits;
+};
+
+Result measure(const FeatureIndex& index, const std::vector<std::vector<float>>& queries, size_t dims,
+               const std::vector<std::vector<uint64_t>>& truth, const std::vector<bool>& live, size_t probes) {
+    std::vector<double> latencies;
+    size_t found = 0, wanted = 0, removed_hits = 0;
+
+    for (size_t q = 0; q < queries.size(); ++q) {
+        const auto start = Clock::now();
+        const std::vector<IndexMatch> matches = index.search(queries[q].data(), dims, kTopK, probes);
+        latencies.push_back(msSince(start) * 1000.0);
+
+        for (const IndexMatch& m : matches) {
+            if (!live[m.image_hash - 1]) ++removed_hits;
+            if (std::find(truth[q].begin(), truth[q].end(), m.image_hash) != truth[q].end()) ++found;
+        }
+        wanted += truth[q].size();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (double l : latencies) sum += l;
+    return {wanted ? double(found) / wanted : 1.0, sum / latencies.size(),
+            latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)], removed_hits};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t images = 1000000, dims = 22, lists = 256, num_queries = 200;
+    try {
+        if (argc > 1) images = std::max<size_t>(kTopK, std::stoul(argv[1]));
+        if (argc > 2) dims = std::max<size_t>(1, std::stoul(argv[2]));
+        if (argc > 3) lists = std::max<size_t>(1, std::stoul(argv[3]));
+        if (argc > 4) num_queries = std::max<size_t>(1, std::stoul(argv[4]));
+    } catch (const std::exception&) {
+        std::cerr << "Usage: " << argv[0] << " [images] [dims] [lists] [queries]\n";
+        return 1;
+    }
+
+    bool ok = checkKernels();
+
+    // ---- data ----
+    const size_t stride = padded_dims(dims);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, kSpread);
+
+    std::vector<float> centres(kCentres * dims);
+    for (float& v : centres) v = unit(rng);
+
+    std::vector<float> padded(images * stride, 0.0f);
+    for (size_t i = 0; i < images; ++i) {
+        const float* centre = &centres[(rng() % kCentres) * dims];
+        for (size_t d = 0; d < dims; ++d) padded[i * stride + d] = centre[d] + noise(rng);
+    }
+
+    std::vector<std::vector<float>> queries(num_queries, std::vector<float>(stride, 0.0f));
+    for (auto& query : queries) {
+        const float* source = &padded[(rng() % images) * stride];
+        for (size_t d = 0; d < dims; ++d) query[d] = source[d] + noise(rng) * 0.1f;
+    }
+
+    // ---- build ----
+    std::cout << "\n" << images << " images of " << dims << " features, " << lists << " lists\n";
+    FeatureIndex index(lists, 8);
+    auto start = Clock::now();
+    for (size_t i = 0; i < images; ++i) index.add(i + 1, i, &padded[i * stride], dims, 0);
+    const double add_ms = msSince(start);
+    index.waitForTraining();
+    std::cout << std::fixed << std::setprecision(1) << "added in " << add_ms << " ms ("
+              << images / add_ms * 1000.0 << " images/s), clustering done after " << msSince(start) << " ms\n";
+
+    // ---- recall and latency ----
+    std::vector<bool> live(images, true);
+    std::vector<std::vector<uint64_t>> truth;
+    std::vector<float> distances;
+    start = Clock::now();
+    for (const auto& query : queries) truth.push_back(bruteForce(padded, stride, live, query.data(), distances));
+    const double brute_us = msSince(start) * 1000.0 / num_queries;
+
+    std::cout << "\nbrute force scan: " << std::setprecision(0) << brute_us << " us per query\n";
+    std::cout << "probes  recall@" << kTopK << "  mean us  p99 us\n";
+    for (size_t probes : {1, 2, 4, 8, 16, 32, 64}) {
+        if (probes > lists) break;
+        const Result r = measure(index, queries, dims, truth, live, probes);
+        std::cout << std::setw(6) << probes << "  " << std::setw(9) << std::setprecision(3) << r.recall
+                  << "  " << std::setw(7) << std::setprecision(1) << r.mean_us
+                  << "  " << std::setw(6) << r.p99_us << "\n";
+    }
+
+    // ---- removal ----
+    size_t removed = 0;
+    for (size_t i = 0; i < images; i += 10) {
+        if (!index.remove(i + 1)) ok = false;
+        live[i] = false;
+        ++removed;
+    }
+    truth.clear();
+    for (const auto& query : queries) truth.push_back(bruteForce(padded, stride, live, query.data(), distances));
+
+    const Result r = measure(index, queries, dims, truth, live, 8);
+    std::cout << "\nremoved " << removed << " images, " << index.size() << " left: recall@" << kTopK << " "
+              << std::setprecision(3) << r.recall << " at 8 probes, " << r.removed_hits
+              << " removed images returned\n";
+    if (r.removed_hits || index.size() != images - removed) ok = false;
+
+    std::cout << (ok ? "\nall checks passed" : "\nSOME CHECKS FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
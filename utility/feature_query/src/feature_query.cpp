@@ -0,0 +1,123 @@
+// Asks a running data_logger for the images whose features are nearest to a given image's,
+// or to an explicit feature vector, and prints them closest first.
+//
+//   feature_query <image_hash_hex> [k]
+//   feature_query --vector 0.41,0.12,... [k]
+// options: --probes N (lists scanned, default from the logger), --endpoint URL
+#include "feature_query.hpp"
+#include "content_hash.hpp"
+#include <zmq.hpp>
+#include <yaml-cpp/yaml.h>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* kConfigPath = "configs/data_logger/PostgreSQL/config.yml";
+
+std::string configuredEndpoint() {
+    std::string endpoint = "ipc:///tmp/feature_query.sock";
+    try {
+        const YAML::Node config = YAML::LoadFile(kConfigPath);
+        if (config["similarity_index"] && config["similarity_index"]["endpoint"])
+            endpoint = config["similarity_index"]["endpoint"].as<std::string>();
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Failed to load " << kConfigPath << " (" << e.what() << "), using "
+                  << endpoint << "\n";
+    }
+    return endpoint;
+}
+
+std::vector<float> parseVector(const std::string& text) {
+    std::vector<float> values;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) values.push_back(std::stof(item));
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <image_hash_hex> | --vector v1,v2,... [k]"
+                  << " [--probes N] [--endpoint URL]\n";
+        return 1;
+    }
+
+    FeatureQuery query{};
+    query.k = 10;
+    std::vector<float> vec;
+    std::string endpoint;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--vector" && i + 1 < argc) {
+                vec = parseVector(argv[++i]);
+            } else if (arg == "--probes" && i + 1 < argc) {
+                query.probes = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--endpoint" && i + 1 < argc) {
+                endpoint = argv[++i];
+            } else if (i == 1) {
+                query.image_hash = std::stoull(arg, nullptr, 16);
+            } else {
+                query.k = static_cast<uint32_t>(std::stoul(arg));
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid argument\n";
+        return 1;
+    }
+    query.dims = static_cast<uint32_t>(vec.size());
+    if (endpoint.empty()) endpoint = configuredEndpoint();
+
+    zmq::context_t ctx{1};
+    zmq::socket_t socket(ctx, zmq::socket_type::req);
+    socket.set(zmq::sockopt::rcvtimeo, 5000);
+    socket.set(zmq::sockopt::linger, 0);
+    socket.connect(endpoint);
+
+    socket.send(zmq::buffer(&query, sizeof(query)), zmq::send_flags::sndmore);
+    socket.send(zmq::buffer(vec), zmq::send_flags::none);
+
+    zmq::message_t reply_msg, matches_msg;
+    if (!socket.recv(reply_msg, zmq::recv_flags::none)) {
+        std::cerr << "No answer from " << endpoint << " (is the data_logger running?)\n";
+        return 1;
+    }
+    if (reply_msg.size() != sizeof(FeatureQueryReply) || !reply_msg.more()
+        || !socket.recv(matches_msg, zmq::recv_flags::none)) {
+        std::cerr << "Malformed reply\n";
+        return 1;
+    }
+
+    FeatureQueryReply reply;
+    std::memcpy(&reply, reply_msg.data(), sizeof(reply));
+    if (reply.status != static_cast<uint32_t>(FeatureQueryStatus::Ok)) {
+        std::cerr << "Query failed: " << query_status_name(reply.status) << "\n";
+        return 1;
+    }
+
+    std::vector<FeatureQueryMatch> matches(reply.count);
+    if (matches_msg.size() != matches.size() * sizeof(FeatureQueryMatch)) {
+        std::cerr << "Malformed reply\n";
+        return 1;
+    }
+    std::memcpy(matches.data(), matches_msg.data(), matches_msg.size());
+
+    std::cout << reply.count << " nearest of " << reply.indexed << " indexed images, searched in "
+              << reply.search_us << " us\n\n";
+    std::cout << std::left << std::setw(6) << "rank" << std::setw(18) << "image_hash"
+              << std::setw(14) << "distance" << std::setw(14) << "last_frame" << "frames\n";
+    for (size_t i = 0; i < matches.size(); ++i) {
+        const FeatureQueryMatch& m = matches[i];
+        std::cout << std::left << std::setw(6) << i + 1 << std::setw(18) << content_hash_hex(m.image_hash)
+                  << std::setw(14) << m.distance << std::setw(14) << m.last_frame << m.frames << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Checks every compiled SIMD variant of the lib/ pixel kernels against the scalar reference,
+// for every supported layout, on odd lengths and on buffers that start off alignment.
+// Prints one line per variant and layout and exits non-zero on the first mismatching kernel.
+//
+//   pixel_kernel_check [iterations]
+#include "pixel_kernels.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// OpenCV type codes: depth in the low 3 bits, channels - 1 above them
+constexpr uint32_t makeFormat(uint32_t depth, uint32_t channels) { return depth | ((channels - 1) << 3); }
+constexpr uint32_t kDepth8U = 0;
+constexpr uint32_t kDepth16U = 2;
+
+// odd sizes around every vector width, plus a few larger ones
+const size_t kLengths[] = {1, 2, 3, 5, 7, 9, 15, 17, 31, 33, 63, 65, 127, 129, 255, 257, 1021, 4099};
+
+// offsets in elements from a 64 byte aligned base
+const size_t kOffsets[] = {0, 1, 3};
+
+std::mt19937 rng(12345);
+
+// Random bytes placed offset elements past an aligned start
+struct Buffer {
+    Buffer(size_t bytes, size_t offset_bytes) : storage(bytes + offset_bytes + 128) {
+        const auto base = reinterpret_cast<uintptr_t>(storage.data());
+        data = storage.data() + ((64 - base % 64) % 64) + offset_bytes;
+        for (size_t i = 0; i < bytes; ++i) data[i] = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> storage;
+    uint8_t* data;
+};
+
+// Output buffer for both variants, pre-filled identically so untouched bytes compare equal
+struct Output {
+    Output(size_t bytes, size_t offset_bytes) : ref(bytes, offset_bytes), test(bytes, offset_bytes), size(bytes) {
+        std::memcpy(test.data, ref.data, bytes);
+    }
+    bool same() const { return std::memcmp(ref.data, test.data, size) == 0; }
+    Buffer ref, test;
+    size_t size;
+};
+
+int failures = 0;
+
+void report(const char* kernel, const char* level, uint32_t format, size_t n, size_t offset) {
+    std::cerr << "MISMATCH " << kernel << " " << level << " format " << format << " n=" << n
+              << " offset=" << offset << "\n";
+    ++failures;
+}
+
+void checkLayout(const PixelKernels& ref, const PixelKernels& test, const char* level, uint32_t format) {
+    const size_t elem = ref.depth_bytes;
+    const size_t channels = ref.channels;
+
+    for (size_t n : kLengths) {
+        for (size_t off : kOffsets) {
+            const size_t off_bytes = off * elem;
+            Buffer src(n * channels * elem, off_bytes);
+
+            {
+                Output out(n * elem, off_bytes);
+                ref.to_gray(src.data, out.ref.data, n);
+                test.to_gray(src.data, out.test.data, n);
+                if (!out.same()) report("to_gray", level, format, n, off);
+            }
+            {
+                std::vector<Output> planes;
+                for (size_t c = 0; c < channels; ++c) planes.emplace_back(n * elem, off_bytes);
+                std::vector<void*> ref_dst, test_dst;
+                for (auto& p : planes) {
+                    ref_dst.push_back(p.ref.data);
+                    test_dst.push_back(p.test.data);
+                }
+                ref.split(src.data, ref_dst.data(), n);
+                test.split(src.data, test_dst.data(), n);
+                for (const auto& p : planes)
+                    if (!p.same()) { report("split", level, format, n, off); break; }
+            }
+            {
+                Output out(n * channels * sizeof(float), off * sizeof(float));
+                ref.normalize(src.data, reinterpret_cast<float*>(out.ref.data), n);
+                test.normalize(src.data, reinterpret_cast<float*>(out.test.data), n);
+                if (!out.same()) report("normalize", level, format, n, off);
+            }
+            {
+                uint32_t ref_bins[256], test_bins[256];
+                ref.histogram(src.data, n, ref_bins);
+                test.histogram(src.data, n, test_bins);
+                if (std::memcmp(ref_bins, test_bins, sizeof(ref_bins)) != 0)
+                    report("histogram", level, format, n, off);
+            }
+        }
+    }
+
+    // odd widths and heights, rows padded so the stride is not a multiple of the row size
+    for (size_t width : {2, 3, 5, 17, 33, 65, 130}) {
+        for (size_t height : {2, 3, 7}) {
+            for (size_t off : kOffsets) {
+                const size_t stride = (width * channels + 3) * elem;
+                Buffer src(stride * height, off * elem);
+                Output out((width / 2) * (height / 2) * channels * elem, off * elem);
+                ref.downscale2x(src.data, stride, out.ref.data, width, height);
+                test.downscale2x(src.data, stride, out.test.data, width, height);
+                if (!out.same()) report("downscale2x", level, format, width * height, off);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 3;
+    const SimdLevel highest = detect_simd_level();
+    std::cout << "CPU supports up to " << simd_level_name(highest) << "\n";
+
+    for (int i = 0; i < iterations; ++i) {
+        for (int l = static_cast<int>(SimdLevel::SSE42); l <= static_cast<int>(highest); ++l) {
+            const SimdLevel level = static_cast<SimdLevel>(l);
+            for (uint32_t depth : {kDepth8U, kDepth16U}) {
+                for (uint32_t channels : {1u, 3u, 4u}) {
+                    const uint32_t format = makeFormat(depth, channels);
+                    const PixelKernels* ref = pixel_kernels(format, SimdLevel::Scalar);
+                    const PixelKernels* test = pixel_kernels(format, level);
+                    if (!ref || !test) {
+                        std::cerr << "MISSING kernels for format " << format << "\n";
+                        ++failures;
+                        continue;
+                    }
+
+                    const int before = failures;
+                    checkLayout(*ref, *test, simd_level_name(level), format);
+                    if (i == 0)
+                        std::cout << simd_level_name(level) << " " << (depth == kDepth8U ? "8U" : "16U")
+                                  << "C" << channels << ": " << (failures == before ? "OK" : "FAILED") << "\n";
+                }
+            }
+        }
+    }
+
+    if (failures) {
+        std::cerr << failures << " mismatches\n";
+        return 1;
+    }
+    std::cout << "All variants match the scalar kernels\n";
+    return 0;
+}
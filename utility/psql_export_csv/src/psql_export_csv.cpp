@@ -1,3 +1,4 @@
+#include "message_headers.hpp"
 #include <pqxx/pqxx>
 #include <yaml-cpp/yaml.h>
 #include <iostream>
@@ -5,6 +6,81 @@
 #include <sstream>
 #include <iomanip>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstring>
+
+using Bytes = std::basic_string<std::byte>;
+
+// -------------------------------------------------------------
+// Binary column decoding
+// feature_vector holds packed float32 values, payload_data a
+// FeatureHeader followed by the image bytes and the features.
+// -------------------------------------------------------------
+void writeFloats(std::ostream &out, const std::byte *data, size_t count) {
+    std::vector<float> values(count);
+    std::memcpy(values.data(), data, count * sizeof(float));
+    for (size_t i = 0; i < count; ++i) {
+        if (i) out << ";";
+        out << values[i];
+    }
+}
+
+void writeHex(std::ostream &out, const std::byte *data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    out << "\\x";
+    for (size_t i = 0; i < size; ++i) {
+        const auto b = std::to_integer<unsigned>(data[i]);
+        out << digits[b >> 4] << digits[b & 0xF];
+    }
+}
+
+std::string decodeFeatureVector(const Bytes &bytes) {
+    std::ostringstream out;
+    writeFloats(out, bytes.data(), bytes.size() / sizeof(float));
+    return out.str();
+}
+
+// "<frame metadata>|<features>|<image bytes as hex>"
+std::string decodePayload(const Bytes &bytes) {
+    FeatureHeader header;
+    if (bytes.size() < sizeof(header))
+        return "<truncated payload>";
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    const size_t image_size = header.image.pixel_count;
+    const size_t feature_bytes = size_t(header.feature_count) * sizeof(float);
+    if (bytes.size() != sizeof(header) + image_size + feature_bytes)
+        return "<malformed payload>";
+
+    const std::byte *image = bytes.data() + sizeof(header);
+    std::ostringstream out;
+    out << "frame=" << header.image.frame_number
+        << ";hash=" << std::hex << std::setw(16) << std::setfill('0')
+        << header.image.content_hash << std::dec
+        << ";size=" << header.image.width << "x" << header.image.height
+        << "x" << header.image.channels
+        << ";codec=" << codec_name(header.image.codec)
+        << ";model=" << std::string(header.model_version,
+                                    strnlen(header.model_version, sizeof(header.model_version)));
+    const std::string shedding = describe_shedding(header);
+    if (!shedding.empty()) out << ";shed=" << shedding;
+    out << "|";
+    writeFloats(out, image + image_size, header.feature_count);
+    out << "|";
+    writeHex(out, image, image_size);
+    return out.str();
+}
+
+std::string fieldText(const pqxx::field &field, const std::string &column) {
+    if (field.is_null())
+        return "";
+    if (column == "feature_vector")
+        return decodeFeatureVector(field.as<Bytes>());
+    if (column == "payload_data")
+        return decodePayload(field.as<Bytes>());
+    return field.c_str(); // BYTEA image_data already arrives hex encoded
+}
 
 // -------------------------------------------------------------
 // Utility: write a pqxx::result to a CSV file
@@ -25,7 +101,7 @@ void writeToCSV(const pqxx::result &rows, const std::string &filename) {
     // Write rows
     for (const auto &row : rows) {
         for (pqxx::row::size_type i = 0; i < row.size(); ++i) {
-            ofs << '"' << row[i].c_str() << '"';
+            ofs << '"' << fieldText(row[i], rows.column_name(i)) << '"';
             if (i < row.size() - 1)
                 ofs << ",";
         }
@@ -37,17 +113,20 @@ void writeToCSV(const pqxx::result &rows, const std::string &filename) {
 
 // -------------------------------------------------------------
 // Estimate average row size (bytes) for a table
+// Partitioned tables hold no rows themselves, so sizes and row
+// counts are summed over their leaf partitions.
 // -------------------------------------------------------------
 double estimateRowSize(pqxx::work &txn, const std::string &table) {
     std::ostringstream q;
     q << R"(
         SELECT
-            CASE WHEN reltuples = 0 THEN 0
-                 ELSE pg_total_relation_size(oid) / reltuples
+            CASE WHEN SUM(GREATEST(c.reltuples, 0)) = 0 THEN 0
+                 ELSE SUM(pg_total_relation_size(c.oid)) / SUM(GREATEST(c.reltuples, 0))
             END AS avg_row_bytes
-        FROM pg_class
-        WHERE relname = )"
-      << txn.quote(table) << ";";
+        FROM pg_partition_tree()"
+      << txn.quote(table) << R"(::regclass) AS t
+        JOIN pg_class c ON c.oid = t.relid
+        WHERE t.isleaf;)";
 
     pqxx::result r = txn.exec(q.str());
     if (r.empty() || r[0]["avg_row_bytes"].is_null()) {
@@ -138,16 +217,17 @@ int main(int argc, char *argv[]) {
 
         if (exporting_join) {
             query << "SELECT "
-                << "i.id AS image_id, "
+                << "i.content_hash AS image_hash, "
                 << "i.timestamp AS image_timestamp, "
                 << "i.image_data AS image_data, "
                 << "f.id AS feature_id, "
                 << "f.feature_vector AS feature_vector, "
-                << "f.model_version AS model_version "
+                << "f.model_version AS model_version, "
+                << "f.shedding AS shedding "
                 << "FROM " << txn.esc(image_table) << " AS i "
                 << "JOIN " << txn.esc(feature_table) << " AS f "
-                << "ON i.id = f.image_id "
-                << "ORDER BY i.id "
+                << "ON i.content_hash = f.image_hash "
+                << "ORDER BY f.id "
                 << "LIMIT " << rowLimit << ";";
             outputFile = "images_features_export.csv";
         }
@@ -0,0 +1,181 @@
+// Stress test and benchmark for the lib/ handoff queues: SpscQueue and MpmcQueue against
+// the mutex-based WorkQueue, item by item and in batches. Every run checks that each item
+// arrived exactly once (and in order for a single producer) before printing its rate.
+//
+//   ring_queue_bench [items_per_producer] [threads]
+#include "ring_queue.hpp"
+#include "work_queue.hpp"
+#include "shutdown_handler.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kCapacity = 1024;
+constexpr size_t kBatch = 32;
+
+// items encode their producer in the top bits, so consumers can check per-producer order
+uint64_t makeItem(size_t producer, uint64_t seq) { return (uint64_t(producer) << 48) | seq; }
+size_t producerOf(uint64_t item) { return size_t(item >> 48); }
+uint64_t seqOf(uint64_t item) { return item & ((uint64_t(1) << 48) - 1); }
+
+// Push/pop one at a time or in batches, for any queue with the WorkQueue interface
+template <typename Queue>
+void produce(Queue& queue, size_t producer, uint64_t count, bool batched) {
+    if (!batched) {
+        for (uint64_t i = 1; i <= count; ++i) queue.push(makeItem(producer, i));
+        return;
+    }
+    std::vector<uint64_t> batch;
+    for (uint64_t i = 1; i <= count;) {
+        batch.clear();
+        for (size_t b = 0; b < kBatch && i <= count; ++b, ++i) batch.push_back(makeItem(producer, i));
+        if constexpr (std::is_same_v<Queue, WorkQueue<uint64_t>>) {
+            for (auto item : batch) queue.push(item);
+        } else {
+            queue.pushBatch(batch.data(), batch.size());
+        }
+    }
+}
+
+struct ConsumerTally {
+    uint64_t items = 0;
+    uint64_t checksum = 0;
+    bool ordered = true;
+};
+
+template <typename Queue>
+void consume(Queue& queue, size_t producers, bool batched, ConsumerTally& tally) {
+    std::vector<uint64_t> last(producers, 0);
+    auto take = [&](uint64_t item) {
+        ++tally.items;
+        tally.checksum += item;
+        // with several consumers an item can overtake another, but never one of its own
+        const size_t p = producerOf(item);
+        if (seqOf(item) <= last[p]) tally.ordered = false;
+        last[p] = seqOf(item);
+    };
+
+    if (!batched) {
+        uint64_t item;
+        while (queue.pop(item)) take(item);
+        return;
+    }
+    std::vector<uint64_t> batch;
+    while (true) {
+        batch.clear();
+        if (queue.popBatch(batch, kBatch) == 0) break;
+        for (auto item : batch) take(item);
+    }
+}
+
+template <typename Queue>
+bool run(const std::string& name, size_t producers, size_t consumers, uint64_t per_producer, bool batched) {
+    Queue queue(kCapacity);
+    std::vector<ConsumerTally> tallies(consumers);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> readers, writers;
+    for (size_t c = 0; c < consumers; ++c)
+        readers.emplace_back([&, c] { consume(queue, producers, batched, tallies[c]); });
+    for (size_t p = 0; p < producers; ++p)
+        writers.emplace_back([&, p] { produce(queue, p, per_producer, batched); });
+
+    for (auto& t : writers) t.join();
+    queue.close();
+    for (auto& t : readers) t.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // sum over every producer p and seq 1..n of (p << 48 | seq)
+    uint64_t expected_checksum = 0;
+    for (size_t p = 0; p < producers; ++p)
+        expected_checksum += per_producer * (uint64_t(p) << 48) + per_producer * (per_producer + 1) / 2;
+
+    ConsumerTally total;
+    for (const auto& t : tallies) {
+        total.items += t.items;
+        total.checksum += t.checksum;
+        total.ordered = total.ordered && t.ordered;
+    }
+
+    const uint64_t expected_items = per_producer * producers;
+    const bool ok = total.items == expected_items && total.checksum == expected_checksum && total.ordered;
+
+    std::cout << std::left << std::setw(34) << name
+              << std::right << std::setw(3) << producers << "p" << std::setw(3) << consumers << "c  "
+              << std::setw(9) << std::fixed << std::setprecision(1)
+              << (expected_items / seconds / 1e6) << " M items/s  "
+              << std::setw(7) << std::setprecision(1) << (seconds * 1e9 / expected_items) << " ns/item  "
+              << (ok ? "ok" : "FAILED") << std::endl;
+
+    if (!ok) {
+        std::cerr << "  got " << total.items << " of " << expected_items << " items, checksum "
+                  << (total.checksum == expected_checksum ? "ok" : "wrong")
+                  << ", order " << (total.ordered ? "ok" : "broken") << std::endl;
+    }
+    return ok;
+}
+
+// A consumer asleep on an empty queue must return promptly once shutdown is requested
+bool checkShutdownWakeup() {
+    MpmcQueue<uint64_t> queue(kCapacity);
+    std::atomic<bool> returned{false};
+    std::chrono::steady_clock::time_point woke;
+
+    std::thread waiter([&] {
+        uint64_t item;
+        while (queue.pop(item)) {}
+        woke = std::chrono::steady_clock::now();
+        returned = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));  // let it fall asleep
+    const auto requested = std::chrono::steady_clock::now();
+    ShutdownHandler::requestShutdown();
+    waiter.join();
+
+    const double us = std::chrono::duration<double, std::micro>(woke - requested).count();
+    std::cout << "shutdown wakeup of a sleeping pop: " << std::fixed << std::setprecision(0)
+              << us << " us" << std::endl;
+    return returned && us < 50000;   // well under the 100 ms timeout safety net
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const uint64_t per_producer = argc >= 2 ? std::stoull(argv[1]) : 2000000;
+    const size_t threads = argc >= 3 ? std::stoul(argv[2]) : 4;
+
+    std::cout << per_producer << " items per producer, capacity " << kCapacity
+              << ", batches of " << kBatch << "\n\n";
+
+    bool ok = true;
+    ok &= run<WorkQueue<uint64_t>>("WorkQueue (mutex)", 1, 1, per_producer, false);
+    ok &= run<SpscQueue<uint64_t>>("SpscQueue", 1, 1, per_producer, false);
+    ok &= run<SpscQueue<uint64_t>>("SpscQueue batched", 1, 1, per_producer, true);
+    ok &= run<MpmcQueue<uint64_t>>("MpmcQueue", 1, 1, per_producer, false);
+    std::cout << "\n";
+    ok &= run<WorkQueue<uint64_t>>("WorkQueue (mutex)", threads, threads, per_producer, false);
+    ok &= run<WorkQueue<uint64_t>>("WorkQueue (mutex) popBatch", threads, threads, per_producer, true);
+    ok &= run<MpmcQueue<uint64_t>>("MpmcQueue", threads, threads, per_producer, false);
+    ok &= run<MpmcQueue<uint64_t>>("MpmcQueue batched", threads, threads, per_producer, true);
+    std::cout << "\n";
+    ok &= run<WorkQueue<uint64_t>>("WorkQueue (mutex)", 1, threads, per_producer, false);
+    ok &= run<MpmcQueue<uint64_t>>("MpmcQueue", 1, threads, per_producer, false);
+    ok &= run<MpmcQueue<uint64_t>>("MpmcQueue batched", 1, threads, per_producer, true);
+    std::cout << "\n";
+
+    // last: shutdown cannot be undone
+    ok &= checkShutdownWakeup();
+
+    std::cout << (ok ? "\nall checks passed" : "\nSOME CHECKS FAILED") << std::endl;
+    return ok ? 0 : 1;
+}